@@ -1,9 +1,475 @@
 # include <RcppArmadillo.h>
 # include <algorithm>
 # include <string>
+# include <vector>
+# include <chrono>
+# include <atomic>
+# include <mutex>
+# include <thread>
+# include <condition_variable>
+# include <functional>
+# include <deque>
+# include <cstring>
+# include <cstdint>
+# ifndef _WIN32
+# include <unistd.h>
+# endif
+# ifdef _OPENMP
+# include <omp.h>
+# endif
 // [[Rcpp::depends(RcppArmadillo)]]
 // [[Rcpp::plugins(cpp11)]]
 
+// Cancellation and progress for long loops: tick() returns true once cancelled. Only the thread that constructed the
+// monitor calls into R; children forward their ticks to a parent, and a detached monitor never calls into R.
+class FarmMonitor {
+private:
+  FarmMonitor* parent;
+  bool forward;
+  bool detached;
+  SEXP callback;
+  std::string stageName;
+  std::mutex stageLock;
+  std::atomic<bool> stop;
+  std::atomic<long long> done, total;
+  std::chrono::steady_clock::time_point lastPoll;
+  std::thread::id owner;
+
+  static void checkInterrupt(void* dummy) {
+    R_CheckUserInterrupt();
+  }
+
+  bool isMaster() const {
+    return std::this_thread::get_id() == owner;
+  }
+
+  void poll() {
+    lastPoll = std::chrono::steady_clock::now();
+    if (R_ToplevelExec(checkInterrupt, NULL) == FALSE) {
+      stop = true;
+      return;
+    }
+    if (callback != R_NilValue) {
+      SEXP call = PROTECT(Rf_lang4(callback, PROTECT(Rf_mkString(stage().c_str())), PROTECT(Rf_ScalarReal((double)done)), 
+                                   PROTECT(Rf_ScalarReal((double)total))));
+      int error = 0;
+      R_tryEvalSilent(call, R_GlobalEnv, &error);
+      UNPROTECT(4);
+      if (error) {
+        stop = true;
+      }
+    }
+  }
+
+public:
+  FarmMonitor(Rcpp::Nullable<Rcpp::Function> progress = R_NilValue) : parent(NULL), forward(false), detached(false), callback(progress.get()), 
+                                                                       stop(false), done(0), total(0), 
+                                                                       lastPoll(std::chrono::steady_clock::now()), 
+                                                                       owner(std::this_thread::get_id()) {}
+
+  FarmMonitor(FarmMonitor* batch, const bool add = false) : parent(batch), forward(add), detached(false), callback(R_NilValue), 
+                                                            stop(false), done(0), total(0), lastPoll(std::chrono::steady_clock::now()), 
+                                                            owner(std::this_thread::get_id()) {}
+
+  void detach() {
+    detached = true;
+    callback = R_NilValue;
+  }
+
+  void begin(const std::string& name, const long long len) {
+    if (parent != NULL) {
+      if (forward) {
+        parent->extend(name, len);
+      }
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(stageLock);
+      stageName = name;
+    }
+    done = 0;
+    total = len;
+    if (callback != R_NilValue && !stop && isMaster()) {
+      poll();
+    }
+  }
+
+  // Adds len units of work to the total without restarting the progress, e.g. for a stage begun by a forwarding child
+  void extend(const std::string& name, const long long len) {
+    {
+      std::lock_guard<std::mutex> lock(stageLock);
+      stageName = name;
+    }
+    total += len;
+  }
+
+  // Takes over the stage and progress of other, e.g. the gate of FarmGraph, and polls as tick() does
+  bool follow(FarmMonitor& other) {
+    {
+      std::lock_guard<std::mutex> lock(stageLock);
+      stageName = other.stage();
+    }
+    total = other.size();
+    done = other.progress();
+    return tick(0);
+  }
+
+  bool tick(const long long k = 1) {
+    if (parent != NULL) {
+      return parent->tick(forward ? k : 0);
+    }
+    done += k;
+    if (!detached && isMaster() && std::chrono::steady_clock::now() - lastPoll >= std::chrono::milliseconds(200)) {
+      poll();
+    }
+    return stop;
+  }
+
+  void cancel() {
+    stop = true;
+  }
+
+  std::string stage() {
+    std::lock_guard<std::mutex> lock(stageLock);
+    return stageName;
+  }
+
+  long long progress() const {
+    return done;
+  }
+
+  long long size() const {
+    return total;
+  }
+
+  bool cancelled() const {
+    return parent != NULL ? parent->cancelled() : stop.load();
+  }
+
+  void abort() const {
+    if (parent == NULL && stop) {
+      throw Rcpp::internal::InterruptedException();
+    }
+  }
+};
+
+// Outcome of one iterative solve: number of iterations, number of tau updates, whether the tolerance was reached, and for
+// Huber regression whether the Newton or SVRG solver converged without falling back to gradient descent
+struct SolveInfo {
+  int ite;
+  int tau;
+  bool conv;
+  bool newton;
+  bool svrg;
+  SolveInfo() : ite(0), tau(0), conv(true), newton(false), svrg(false) {}
+
+  const char* solver() const {
+    return newton ? "newton" : (svrg ? "svrg" : "gd");
+  }
+};
+
+// Solvers of Huber regression. The entry points take the code of solverCode in R and convert it with huberSolver.
+enum HuberSolver { SOLVER_GD = 0, SOLVER_NEWTON = 1, SOLVER_SVRG = 2 };
+
+inline HuberSolver huberSolver(const int code) {
+  if (code < SOLVER_GD || code > SOLVER_SVRG) {
+    Rcpp::stop("solver must be one of \"gd\", \"newton\" or \"svrg\"");
+  }
+  return (HuberSolver)code;
+}
+
+// Opt-in stage timings and per-column solver counts; every call returns immediately when disabled.
+class FarmProfile {
+private:
+  bool on;
+  std::string prefix;
+  std::vector<std::string> stageNames, slotNames;
+  std::vector<double> stageTimes;
+  std::vector<arma::uvec> slotIte, slotTau, slotNonConv;
+  std::chrono::steady_clock::time_point last;
+
+public:
+  FarmProfile(const bool enable) : on(enable) {
+    if (on) {
+      last = std::chrono::steady_clock::now();
+    }
+  }
+
+  bool enabled() const {
+    return on;
+  }
+
+  void setSample(const std::string& sample) {
+    prefix = sample.empty() ? "" : sample + ".";
+  }
+
+  void stage(const std::string& name) {
+    if (!on) {
+      return;
+    }
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    stageNames.push_back(prefix + name);
+    stageTimes.push_back(std::chrono::duration<double>(now - last).count());
+    last = now;
+  }
+
+  int addSlot(const std::string& name, const int len) {
+    if (!on) {
+      return -1;
+    }
+    slotNames.push_back(prefix + name);
+    slotIte.push_back(arma::zeros<arma::uvec>(len));
+    slotTau.push_back(arma::zeros<arma::uvec>(len));
+    slotNonConv.push_back(arma::zeros<arma::uvec>(len));
+    return slotNames.size() - 1;
+  }
+
+  void record(const int slot, const int j, const SolveInfo& info) {
+    if (!on) {
+      return;
+    }
+    slotIte[slot](j) += info.ite;
+    slotTau[slot](j) += info.tau;
+    slotNonConv[slot](j) += !info.conv;
+  }
+
+  // Appends the stages and slots of other, e.g. of a sample profiled on its own thread, and restarts the stage clock
+  void merge(const FarmProfile& other) {
+    if (!on) {
+      return;
+    }
+    stageNames.insert(stageNames.end(), other.stageNames.begin(), other.stageNames.end());
+    stageTimes.insert(stageTimes.end(), other.stageTimes.begin(), other.stageTimes.end());
+    slotNames.insert(slotNames.end(), other.slotNames.begin(), other.slotNames.end());
+    slotIte.insert(slotIte.end(), other.slotIte.begin(), other.slotIte.end());
+    slotTau.insert(slotTau.end(), other.slotTau.begin(), other.slotTau.end());
+    slotNonConv.insert(slotNonConv.end(), other.slotNonConv.begin(), other.slotNonConv.end());
+    last = std::chrono::steady_clock::now();
+  }
+
+  Rcpp::List toList() const {
+    int m = slotNames.size();
+    Rcpp::NumericVector times(stageTimes.begin(), stageTimes.end());
+    times.names() = Rcpp::wrap(stageNames);
+    Rcpp::List ite(m), tau(m), nonConv(m);
+    double totalTau = 0, totalNonConv = 0;
+    for (int i = 0; i < m; i++) {
+      ite[i] = Rcpp::NumericVector(slotIte[i].begin(), slotIte[i].end());
+      tau[i] = Rcpp::NumericVector(slotTau[i].begin(), slotTau[i].end());
+      nonConv[i] = Rcpp::NumericVector(slotNonConv[i].begin(), slotNonConv[i].end());
+      totalTau += arma::accu(slotTau[i]);
+      totalNonConv += arma::accu(slotNonConv[i]);
+    }
+    ite.names() = Rcpp::wrap(slotNames);
+    tau.names() = Rcpp::wrap(slotNames);
+    nonConv.names() = Rcpp::wrap(slotNames);
+    return Rcpp::List::create(Rcpp::Named("stageTime") = times, Rcpp::Named("iterations") = ite, Rcpp::Named("tauUpdates") = tau,
+                              Rcpp::Named("nonConverged") = nonConv, Rcpp::Named("totalTauUpdates") = totalTau,
+                              Rcpp::Named("totalNonConverged") = totalNonConv);
+  }
+};
+
+// Execution plan of the covariance and eigen stages, usually from farmPlan; the default is the exact procedure on one
+// thread. Threads are capped by the processors, and pairOffsets falls back to all pairs for a small sample.
+struct FarmPlan {
+  int tile;
+  int offsets;
+  int nEigen;
+  int threads;
+  FarmPlan() : tile(0), offsets(0), nEigen(0), threads(1) {}
+
+  FarmPlan(Rcpp::Nullable<Rcpp::List> plan) : tile(0), offsets(0), nEigen(0), threads(1) {
+    if (plan.isNull()) {
+      return;
+    }
+    Rcpp::List rst(plan.get());
+    tile = std::max(Rcpp::as<int>(rst["tile"]), 0);
+    offsets = std::max(Rcpp::as<int>(rst["offsets"]), 0);
+    nEigen = std::max(Rcpp::as<int>(rst["nEigen"]), 0);
+# ifdef _OPENMP
+    threads = std::min(std::max(Rcpp::as<int>(rst["threads"]), 1), omp_get_num_procs());
+# endif
+  }
+
+  int pairOffsets(const int n) const {
+    return 2 * offsets < n ? offsets : 0;
+  }
+};
+
+// Process-wide pool of worker threads for FarmGraph, grown on demand; a forked child gets a new pool.
+class FarmPool {
+private:
+  std::vector<std::thread> workers;
+  std::deque<std::function<void()> > queue;
+  std::mutex queueLock;
+  std::condition_variable queueCond;
+  long owner;
+
+  FarmPool() : owner(processId()) {}
+
+  static long processId() {
+# ifndef _WIN32
+    return (long)getpid();
+# else
+    return 0;
+# endif
+  }
+
+  void work() {
+    while (true) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(queueLock);
+        queueCond.wait(lock, [this] { return !queue.empty(); });
+        task = std::move(queue.front());
+        queue.pop_front();
+      }
+      task();
+    }
+  }
+
+public:
+  // Called on the R thread only. The pool is never destroyed: its threads wait for tasks until the process exits, and in
+  // a child they and their locks are not usable.
+  static FarmPool& instance() {
+    static FarmPool* pool = NULL;
+    if (pool == NULL || pool->owner != processId()) {
+      pool = new FarmPool();
+    }
+    return *pool;
+  }
+
+  void reserve(const int threads) {
+    std::lock_guard<std::mutex> lock(queueLock);
+    while ((int)workers.size() < threads) {
+      workers.push_back(std::thread(&FarmPool::work, this));
+    }
+  }
+
+  void submit(const std::function<void()>& task) {
+    {
+      std::lock_guard<std::mutex> lock(queueLock);
+      queue.push_back(task);
+    }
+    queueCond.notify_one();
+  }
+};
+
+// Stages of a testing procedure and their dependencies, run on FarmPool. Stages must not call into R: the calling
+// thread reports their progress, polls for interrupts and raises the first error of a stage.
+class FarmGraph {
+private:
+  struct Stage {
+    std::function<void(FarmMonitor&)> run;
+    std::vector<int> next;
+    int wait;
+  };
+  std::vector<Stage> stages;
+  std::deque<int> ready;
+  std::mutex graphLock;
+  std::condition_variable graphCond;
+  FarmMonitor gate;
+  FarmPool* pool;
+  int finished, running, slots;
+  std::string error;
+
+  // Submits ready stages while fewer than slots are running; called with graphLock held
+  void launch() {
+    while (running < slots && !ready.empty()) {
+      int i = ready.front();
+      ready.pop_front();
+      running++;
+      pool->submit([this, i] { execute(i); });
+    }
+  }
+
+  void execute(const int i) {
+    FarmMonitor mon(&gate, true);
+    try {
+      if (!gate.cancelled()) {
+        stages[i].run(mon);
+      }
+    } catch (std::exception& e) {
+      std::lock_guard<std::mutex> lock(graphLock);
+      if (error.empty()) {
+        error = e.what();
+      }
+      gate.cancel();
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(graphLock);
+      if (error.empty()) {
+        error = "unknown error";
+      }
+      gate.cancel();
+    }
+    std::lock_guard<std::mutex> lock(graphLock);
+    for (size_t k = 0; k < stages[i].next.size(); k++) {
+      int j = stages[i].next[k];
+      if (--stages[j].wait == 0) {
+        ready.push_back(j);
+      }
+    }
+    running--;
+    finished++;
+    launch();
+    graphCond.notify_all();
+  }
+
+public:
+  FarmGraph() : pool(NULL), finished(0), running(0), slots(1) {
+    gate.detach();
+  }
+
+  // Adds a stage that runs after the stages in after, and returns its index
+  int add(const std::function<void(FarmMonitor&)>& run, const std::vector<int>& after = std::vector<int>()) {
+    Stage stage;
+    stage.run = run;
+    stage.wait = after.size();
+    stages.push_back(stage);
+    for (size_t k = 0; k < after.size(); k++) {
+      stages[after[k]].next.push_back(stages.size() - 1);
+    }
+    return stages.size() - 1;
+  }
+
+  // Runs at most threads stages at a time, each with up to inner OpenMP threads, and returns when all the stages are done.
+  // The stages at a time are capped so that they use no more threads than the machine has in total.
+  void run(FarmMonitor& mon, const int threads, const int inner = 1) {
+    int m = stages.size();
+    int cores = std::max((int)std::thread::hardware_concurrency(), 1);
+    slots = std::max(std::min(threads, cores / std::max(inner, 1)), 1);
+    pool = &FarmPool::instance();
+    pool->reserve(slots);
+    {
+      std::lock_guard<std::mutex> lock(graphLock);
+      for (int i = 0; i < m; i++) {
+        if (stages[i].wait == 0) {
+          ready.push_back(i);
+        }
+      }
+      launch();
+    }
+    while (true) {
+      bool all;
+      {
+        std::unique_lock<std::mutex> lock(graphLock);
+        graphCond.wait_for(lock, std::chrono::milliseconds(100), [this, m] { return finished == m; });
+        all = finished == m;
+      }
+      if (mon.follow(gate)) {
+        gate.cancel();
+      }
+      if (all) {
+        break;
+      }
+    }
+    mon.abort();
+    if (!error.empty()) {
+      Rcpp::stop(error);
+    }
+  }
+};
+
 // [[Rcpp::export]]
 int sgn(const double x) {
   return (x > 0) - (x < 0);
@@ -25,154 +491,1273 @@ double rootf1(const arma::vec& resSq, const int n, const double rhs, double low,
     } else {
       low = mid;
     }
-    ite++;
+    ite++;
+  }
+  return 0.5 * (low + up);
+}
+
+// [[Rcpp::export]]
+double f2(const double x, const arma::vec& resSq, const int N, const double rhs) {
+  return arma::mean(arma::min(resSq / x, arma::ones(N))) - rhs;
+}
+
+// [[Rcpp::export]]
+double rootf2(const arma::vec& resSq, const int n, const int d, const int N, const double rhs, double low, double up, const double tol = 0.001, 
+              const int maxIte = 500) {
+  int ite = 0;
+  while (ite <= maxIte && up - low > tol) {
+    double mid = 0.5 * (up + low);
+    double val = f2(mid, resSq, N, rhs);
+    if (val < 0) {
+      up = mid;
+    } else {
+      low = mid;
+    }
+    ite++;
+  }
+  return 0.5 * (low + up);
+}
+
+// [[Rcpp::export]]
+double g1(const double x, const arma::vec& resSq, const int n, const double rhs) {
+  return arma::mean(arma::min(resSq / x, arma::ones(n))) - rhs;
+}
+
+// [[Rcpp::export]]
+double rootg1(const arma::vec& resSq, const int n, const double rhs, double low, double up, const double tol = 0.001, const int maxIte = 500) {
+  int ite = 0;
+  while (ite <= maxIte && up - low > tol) {
+    double mid = 0.5 * (up + low);
+    double val = g1(mid, resSq, n, rhs);
+    if (val < 0) {
+      up = mid;
+    } else {
+      low = mid;
+    }
+    ite++;
+  }
+  return 0.5 * (low + up);
+}
+
+// [[Rcpp::export]]
+double huberDer(const arma::vec& res, const double tau, const int n) {
+  double rst = 0.0;
+  for (int i = 0; i < n; i++) {
+    double cur = res(i);
+    rst -= std::abs(cur) <= tau ? cur : tau * sgn(cur);
+  }
+  return rst / n;
+}
+
+// Problems solved together by huberMeanLanes in the column loops, e.g. 4 columns with their squares, which fill two AVX2
+// registers or one AVX-512 register of doubles
+const int HUBER_LANES = 8;
+
+// huberDer of the active lanes in one pass, plus the terms of zeros unstored observations equal to 0.
+void laneDer(const double* z, const int n, const int L, const std::vector<double>& center, const std::vector<double>& mu, 
+             const std::vector<double>& tau, const std::vector<char>& active, std::vector<double>& der, const int zeros) {
+  std::vector<double> rst(L, 0.0);
+  for (int i = 0; i < n; i++) {
+    const double* zi = z + (size_t)i * L;
+    for (int l = 0; l < L; l++) {
+      double cur = zi[l] - center[l] - mu[l];
+      rst[l] -= std::min(std::max(cur, -tau[l]), tau[l]);
+    }
+  }
+  for (int l = 0; l < L; l++) {
+    if (active[l]) {
+      if (zeros > 0) {
+        rst[l] -= zeros * std::min(std::max(-center[l] - mu[l], -tau[l]), tau[l]);
+      }
+      der[l] = rst[l] / (n + zeros);
+    }
+  }
+}
+
+// rootf1 of the active lanes, whose bisections run in lockstep so that every evaluation pass serves all of them
+void laneTau(const double* z, const int n, const int L, const std::vector<double>& center, const std::vector<double>& mu, const double rhs, 
+             const std::vector<char>& active, std::vector<double>& resSq, std::vector<double>& tau, const int zeros, const double tol = 0.001, 
+             const int maxIte = 500) {
+  std::vector<double> low(L, arma::datum::inf), up(L, 0.0), mid(L), val(L);
+  std::vector<char> run(active);
+  for (int i = 0; i < n; i++) {
+    const double* zi = z + (size_t)i * L;
+    double* ri = resSq.data() + (size_t)i * L;
+    for (int l = 0; l < L; l++) {
+      double cur = zi[l] - center[l] - mu[l];
+      ri[l] = cur * cur;
+      low[l] = std::min(low[l], ri[l]);
+      up[l] += ri[l];
+    }
+  }
+  std::vector<double> zeroSq(L);
+  for (int l = 0; l < L; l++) {
+    zeroSq[l] = (center[l] + mu[l]) * (center[l] + mu[l]);
+    if (zeros > 0) {
+      low[l] = std::min(low[l], zeroSq[l]);
+      up[l] += zeros * zeroSq[l];
+    }
+  }
+  int ite = 1;
+  while (ite <= maxIte) {
+    bool any = false;
+    for (int l = 0; l < L; l++) {
+      run[l] = run[l] && up[l] - low[l] > tol;
+      any = any || run[l];
+      mid[l] = 0.5 * (up[l] + low[l]);
+      val[l] = 0.0;
+    }
+    if (!any) {
+      break;
+    }
+    for (int i = 0; i < n; i++) {
+      const double* ri = resSq.data() + (size_t)i * L;
+      for (int l = 0; l < L; l++) {
+        val[l] += std::min(ri[l] / mid[l], 1.0);
+      }
+    }
+    for (int l = 0; l < L; l++) {
+      if (run[l]) {
+        if (zeros > 0) {
+          val[l] += zeros * std::min(zeroSq[l] / mid[l], 1.0);
+        }
+        if (val[l] / (n + zeros) - rhs < 0) {
+          up[l] = mid[l];
+        } else {
+          low[l] = mid[l];
+        }
+      }
+    }
+    ite++;
+  }
+  for (int l = 0; l < L; l++) {
+    if (active[l]) {
+      tau[l] = std::sqrt((long double)(0.5 * (low[l] + up[l])));
+    }
+  }
+}
+
+// Tuning-free Huber means of L samples in lockstep, observation i of lane l at z[i * L + l]. Each lane gets the
+// estimate of a single-lane solve; with zeros > 0, each lane has zeros more observations equal to 0 that are not
+// stored.
+void huberMeanLanes(const double* z, const int n, const int L, double* mean, SolveInfo* info, const double tol = 0.001, 
+                    const int iteMax = 500, const int zeros = 0) {
+  const int N = n + zeros;
+  const double rhs = std::log(N) / N;
+  std::vector<double> center(L, 0.0), var(L, 0.0), tau(L), mu(L, 0.0), muDiff(L), derOld(L, 0.0), derNew(L, 0.0), derDiff(L);
+  std::vector<double> resSq((size_t)n * L);
+  std::vector<char> active(L, true);
+  std::vector<int> ite(L, 1);
+  for (int i = 0; i < n; i++) {
+    for (int l = 0; l < L; l++) {
+      center[l] += z[(size_t)i * L + l];
+    }
+  }
+  for (int l = 0; l < L; l++) {
+    center[l] /= N;
+  }
+  for (int i = 0; i < n; i++) {
+    for (int l = 0; l < L; l++) {
+      double cur = z[(size_t)i * L + l] - center[l];
+      var[l] += cur * cur;
+    }
+  }
+  for (int l = 0; l < L; l++) {
+    var[l] += zeros * center[l] * center[l];
+    tau[l] = std::sqrt(var[l] / (N - 1)) * std::sqrt((long double)N / std::log(N));
+  }
+  laneDer(z, n, L, center, mu, tau, active, derOld, zeros);
+  for (int l = 0; l < L; l++) {
+    mu[l] = muDiff[l] = -derOld[l];
+  }
+  laneTau(z, n, L, center, mu, rhs, active, resSq, tau, zeros);
+  laneDer(z, n, L, center, mu, tau, active, derNew, zeros);
+  bool any = false;
+  for (int l = 0; l < L; l++) {
+    derDiff[l] = derNew[l] - derOld[l];
+    active[l] = std::abs(derNew[l]) > tol && ite[l] <= iteMax;
+    any = any || active[l];
+  }
+  while (any) {
+    for (int l = 0; l < L; l++) {
+      if (active[l]) {
+        double alpha = 1.0;
+        double cross = muDiff[l] * derDiff[l];
+        if (cross > 0) {
+          double a1 = cross / derDiff[l] * derDiff[l];
+          double a2 = muDiff[l] * muDiff[l] / cross;
+          alpha = std::min(std::min(a1, a2), 100.0);
+        }
+        derOld[l] = derNew[l];
+        muDiff[l] = -alpha * derNew[l];
+        mu[l] += muDiff[l];
+      }
+    }
+    laneTau(z, n, L, center, mu, rhs, active, resSq, tau, zeros);
+    laneDer(z, n, L, center, mu, tau, active, derNew, zeros);
+    any = false;
+    for (int l = 0; l < L; l++) {
+      if (active[l]) {
+        derDiff[l] = derNew[l] - derOld[l];
+        ite[l]++;
+        active[l] = std::abs(derNew[l]) > tol && ite[l] <= iteMax;
+        any = any || active[l];
+      }
+    }
+  }
+  for (int l = 0; l < L; l++) {
+    mean[l] = mu[l] + center[l];
+    info[l].ite = ite[l] - 1;
+    info[l].tau = ite[l];
+    info[l].conv = std::abs(derNew[l]) <= tol;
+  }
+}
+
+double huberMeanInfo(const arma::vec& X, const int n, SolveInfo* info, const double tol = 0.001, const int iteMax = 500) {
+  double mean;
+  huberMeanLanes(X.memptr(), n, 1, &mean, info, tol, iteMax);
+  return mean;
+}
+
+// [[Rcpp::export]]
+double huberMean(const arma::vec& X, const int n, const double tol = 0.001, const int iteMax = 500) {
+  SolveInfo info;
+  return huberMeanInfo(X, n, &info, tol, iteMax);
+}
+
+// Huber means of the column x and of its square as two lanes of huberMeanLanes; only the second if infoMean is NULL.
+void huberMeanSecondInfo(const double* x, const int n, double& mean, double& second, SolveInfo* infoMean, SolveInfo* infoSecond, 
+                         const double tol = 0.001, const int iteMax = 500, const int zeros = 0) {
+  int L = infoMean != NULL ? 2 : 1;
+  std::vector<double> z((size_t)n * L);
+  for (int i = 0; i < n; i++) {
+    if (L == 2) {
+      z[2 * i] = x[i];
+    }
+    z[(size_t)i * L + L - 1] = x[i] * x[i];
+  }
+  double est[2];
+  SolveInfo info[2];
+  huberMeanLanes(z.data(), n, L, est, info, tol, iteMax, zeros);
+  if (infoMean != NULL) {
+    mean = est[0];
+    *infoMean = info[0];
+  }
+  second = est[L - 1];
+  *infoSecond = info[L - 1];
+}
+
+// [[Rcpp::export]]
+arma::vec huberMeanSecond(const arma::vec& X, const int n, const double tol = 0.001, const int iteMax = 500) {
+  SolveInfo infoMean, infoSecond;
+  arma::vec rst(2);
+  huberMeanSecondInfo(X.memptr(), n, rst(0), rst(1), &infoMean, &infoSecond, tol, iteMax);
+  return rst;
+}
+
+// Histogram sketch of a centered sample on the asinh scale for the binned Huber mean, with the count, sum, sum of
+// squares and range of each bin.
+class HuberSketch {
+private:
+  std::vector<double> cnt, sum, sq, lo, hi;
+
+  // Sum of squares of the centered observations of bin b around a
+  double binResSq(const int b, const double a) const {
+    return std::max(sq[b] - 2 * a * sum[b] + cnt[b] * a * a, 0.0);
+  }
+
+public:
+  int n;
+  double center, var, yMin, yMax;
+
+  HuberSketch(const double* x, const int n, const int bins) : n(n), center(0), var(0) {
+    double xMin = arma::datum::inf, xMax = -arma::datum::inf;
+    for (int i = 0; i < n; i++) {
+      center += x[i];
+      xMin = std::min(xMin, x[i]);
+      xMax = std::max(xMax, x[i]);
+    }
+    center /= n;
+    for (int i = 0; i < n; i++) {
+      double cur = x[i] - center;
+      var += cur * cur;
+    }
+    var = n > 1 ? var / (n - 1) : 0;
+    yMin = xMin - center;
+    yMax = xMax - center;
+    double s = std::sqrt(var);
+    double uMin = s > 0 ? std::asinh(yMin / s) : 0, uMax = s > 0 ? std::asinh(yMax / s) : 0;
+    double scale = uMax > uMin ? bins / (uMax - uMin) : 0;
+    std::vector<double> c(bins, 0.0), sm(bins, 0.0), sqr(bins, 0.0), l(bins, arma::datum::inf), h(bins, -arma::datum::inf);
+    for (int i = 0; i < n; i++) {
+      double y = x[i] - center;
+      int b = scale > 0 ? std::min((int)((std::asinh(y / s) - uMin) * scale), bins - 1) : 0;
+      c[b]++;
+      sm[b] += y;
+      sqr[b] += y * y;
+      l[b] = std::min(l[b], y);
+      h[b] = std::max(h[b], y);
+    }
+    for (int b = 0; b < bins; b++) {
+      if (c[b] > 0) {
+        cnt.push_back(c[b]);
+        sum.push_back(sm[b]);
+        sq.push_back(sqr[b]);
+        lo.push_back(l[b]);
+        hi.push_back(h[b]);
+      }
+    }
+  }
+
+  // Sum of clamp(y - a, -tau, tau), with a bin that straddles a breakpoint approximated by its mean
+  double score(const double a, const double tau) const {
+    double rst = 0;
+    for (size_t b = 0; b < cnt.size(); b++) {
+      if (lo[b] - a >= -tau && hi[b] - a <= tau) {
+        rst += sum[b] - cnt[b] * a;
+      } else {
+        rst += cnt[b] * std::min(std::max(sum[b] / cnt[b] - a, -tau), tau);
+      }
+    }
+    return rst;
+  }
+
+  // Lower and upper bounds of the score at a over all tau in [tauLo, tauUp]. The score is non-decreasing in y, so a bin
+  // is bounded by its range, and it is exact if it lies within the linear part for every such tau.
+  void scoreBounds(const double a, const double tauLo, const double tauUp, double& low, double& up) const {
+    low = up = 0;
+    for (size_t b = 0; b < cnt.size(); b++) {
+      double rl = lo[b] - a, rh = hi[b] - a;
+      if (rl >= -tauLo && rh <= tauLo) {
+        low += sum[b] - cnt[b] * a;
+        up += sum[b] - cnt[b] * a;
+      } else {
+        low += cnt[b] * (rl >= 0 ? std::min(rl, tauLo) : std::max(rl, -tauUp));
+        up += cnt[b] * (rh >= 0 ? std::min(rh, tauUp) : std::max(rh, -tauLo));
+      }
+    }
+  }
+
+  // Sum of squares of y - a
+  double resSq(const double a) const {
+    double rst = 0;
+    for (size_t b = 0; b < cnt.size(); b++) {
+      rst += binResSq(b, a);
+    }
+    return rst;
+  }
+
+  // Smallest squared distance from a to a bin, the start of the bisection of the tau equation
+  double resSqMin(const double a) const {
+    double rst = arma::datum::inf;
+    for (size_t b = 0; b < cnt.size(); b++) {
+      double d = lo[b] > a ? lo[b] - a : (hi[b] < a ? a - hi[b] : 0);
+      rst = std::min(rst, d * d);
+    }
+    return rst;
+  }
+
+  // Lower and upper bounds of the sum of min((y - a)^2 / t, 1) over all a in [aLo, aUp]; with aLo = aUp and no bin
+  // straddling sqrt(t), both are the exact sum, and the midpoint is used as its approximation in the iterations
+  void tauBounds(const double aLo, const double aUp, const double t, double& low, double& up) const {
+    low = up = 0;
+    for (size_t b = 0; b < cnt.size(); b++) {
+      double dMin = lo[b] > aUp ? lo[b] - aUp : (hi[b] < aLo ? aLo - hi[b] : 0);
+      double dMax = std::max(hi[b] - aLo, aUp - lo[b]);
+      if (dMax * dMax <= t) {
+        double m = std::min(std::max(sum[b] / cnt[b], aLo), aUp);
+        low += binResSq(b, m) / t;
+        up += std::max(binResSq(b, aLo), binResSq(b, aUp)) / t;
+      } else if (dMin * dMin >= t) {
+        low += cnt[b];
+        up += cnt[b];
+      } else {
+        low += cnt[b] * dMin * dMin / t;
+        up += cnt[b] * std::min(dMax * dMax / t, 1.0);
+      }
+    }
+  }
+};
+
+// rootf1 at the centered location a on the sketch, with the start, stopping rule and midpoint of laneTau
+double sketchTau(const HuberSketch& sk, const double a, const double rhs, const double tol = 0.001, const int maxIte = 500) {
+  double low = sk.resSqMin(a), up = sk.resSq(a), fLo, fUp;
+  int ite = 1;
+  while (ite <= maxIte && up - low > tol) {
+    double mid = 0.5 * (up + low);
+    sk.tauBounds(a, a, mid, fLo, fUp);
+    if (0.5 * (fLo + fUp) / sk.n - rhs < 0) {
+      up = mid;
+    } else {
+      low = mid;
+    }
+    ite++;
+  }
+  return std::sqrt((long double)(0.5 * (low + up)));
+}
+
+// Interval of centered locations that contains every output the exact solver could return on the sample.
+void sketchBracket(const HuberSketch& sk, const double rhs, const double tol, double& aLo, double& aUp) {
+  const int cells = 16, steps = 40;
+  double bound = sk.n * tol, target = sk.n * rhs;
+  aLo = sk.yMin - tol;
+  aUp = sk.yMax + tol;
+  for (int round = 0; round < 50; round++) {
+    double width = (aUp - aLo) / cells, newLo = arma::datum::inf, newUp = -arma::datum::inf;
+    for (int c = 0; c < cells; c++) {
+      double cLo = aLo + c * width, cUp = c == cells - 1 ? aUp : cLo + width, fLo, fUp;
+      double tMax = std::max(sk.resSq(cLo), sk.resSq(cUp));
+      double low = 0, up = tMax;
+      for (int s = 0; s < steps; s++) {
+        double mid = 0.5 * (low + up);
+        sk.tauBounds(cLo, cUp, mid, fLo, fUp);
+        if (fLo > target) {
+          low = mid;
+        } else {
+          up = mid;
+        }
+      }
+      double tauLo = std::sqrt(std::max(low - tol, 0.0));
+      low = 0;
+      up = tMax;
+      for (int s = 0; s < steps; s++) {
+        double mid = 0.5 * (low + up);
+        sk.tauBounds(cLo, cUp, mid, fLo, fUp);
+        if (fUp < target) {
+          up = mid;
+        } else {
+          low = mid;
+        }
+      }
+      double tauUp = std::sqrt(up + tol), sLo, sUp;
+      sk.scoreBounds(cUp, tauLo, tauUp, sLo, sUp);
+      if (sLo > bound) {
+        continue;
+      }
+      sk.scoreBounds(cLo, tauLo, tauUp, sLo, sUp);
+      if (sUp < -bound) {
+        continue;
+      }
+      newLo = std::min(newLo, cLo);
+      newUp = std::max(newUp, cUp);
+    }
+    if (newLo > newUp) {
+      aLo = arma::datum::inf;
+      aUp = -arma::datum::inf;
+      return;
+    }
+    bool stalled = newUp - newLo > 0.99 * (aUp - aLo);
+    aLo = newLo;
+    aUp = newUp;
+    if (stalled) {
+      break;
+    }
+  }
+}
+
+// Approximate tuning-free Huber mean from a sketch of bins bins. bound, if not NULL, receives a certified bound on the
+// distance to the exact estimate, infinite if none can be certified.
+double huberMeanBinnedInfo(const double* x, const int n, const int bins, double* bound, SolveInfo* info, const double tol = 0.001, 
+                           const int iteMax = 500) {
+  if (n < 2) {
+    info->ite = info->tau = 0;
+    info->conv = true;
+    if (bound != NULL) {
+      *bound = 0;
+    }
+    return n == 1 ? x[0] : arma::datum::nan;
+  }
+  for (int i = 0; i < n; i++) {
+    if (!std::isfinite(x[i])) {
+      info->ite = info->tau = 0;
+      info->conv = false;
+      if (bound != NULL) {
+        *bound = arma::datum::nan;
+      }
+      return arma::datum::nan;
+    }
+  }
+  const double rhs = std::log(n) / n;
+  HuberSketch sk(x, n, bins);
+  double tau = std::sqrt(sk.var) * std::sqrt((long double)n / std::log(n));
+  double derOld = -sk.score(0, tau) / n;
+  double mu = -derOld, muDiff = -derOld;
+  tau = sketchTau(sk, mu, rhs);
+  double derNew = -sk.score(mu, tau) / n, derDiff = derNew - derOld;
+  int ite = 1;
+  while (std::abs(derNew) > tol && ite <= iteMax) {
+    double alpha = 1.0;
+    double cross = muDiff * derDiff;
+    if (cross > 0) {
+      double a1 = cross / derDiff * derDiff;
+      double a2 = muDiff * muDiff / cross;
+      alpha = std::min(std::min(a1, a2), 100.0);
+    }
+    derOld = derNew;
+    muDiff = -alpha * derNew;
+    mu += muDiff;
+    tau = sketchTau(sk, mu, rhs);
+    derNew = -sk.score(mu, tau) / n;
+    derDiff = derNew - derOld;
+    ite++;
+  }
+  info->ite = ite - 1;
+  info->tau = ite;
+  info->conv = std::abs(derNew) <= tol;
+  if (bound != NULL) {
+    double aLo, aUp;
+    sketchBracket(sk, rhs, tol, aLo, aUp);
+    *bound = aLo <= aUp ? std::max(mu - aLo, aUp - mu) : arma::datum::inf;
+  }
+  return mu + sk.center;
+}
+
+// [[Rcpp::export]]
+Rcpp::NumericVector huberMeanBinned(const arma::vec& X, const int n, const int bins = 1024, const double tol = 0.001, 
+                                    const int iteMax = 500) {
+  SolveInfo info;
+  double bound;
+  Rcpp::NumericVector rst = Rcpp::NumericVector::create(huberMeanBinnedInfo(X.memptr(), n, bins, &bound, &info, tol, iteMax));
+  rst.attr("bound") = bound;
+  rst.attr("iterations") = info.ite;
+  return rst;
+}
+
+// Column j of a data matrix as doubles: a double column without a copy, an integer one converted into buf.
+inline const double* dataCol(const arma::mat& X, const int j, arma::vec& buf) {
+  return X.colptr(j);
+}
+
+inline const double* dataCol(const arma::Mat<int>& X, const int j, arma::vec& buf) {
+  int n = X.n_rows;
+  const int* x = X.colptr(j);
+  buf.set_size(n);
+  for (int i = 0; i < n; i++) {
+    buf(i) = x[i] == NA_INTEGER ? NA_REAL : x[i];
+  }
+  return buf.memptr();
+}
+
+// Column j as an arma::vec for the estimators that take one by const reference. For double data this is a read-only view
+// of the column, so passing it on copies nothing; integer columns are converted into a new vector.
+inline arma::vec dataColVec(const arma::mat& X, const int j) {
+  return arma::vec(const_cast<double*>(X.colptr(j)), X.n_rows, false, true);
+}
+
+inline arma::vec dataColVec(const arma::Mat<int>& X, const int j) {
+  arma::vec buf;
+  dataCol(X, j, buf);
+  return buf;
+}
+
+// The nnz non-zeros of column j of a sparse matrix, with their row indices in *rows unless rows is NULL.
+inline const double* sparseCol(const arma::sp_mat& X, const int j, int& nnz, const arma::uword** rows = NULL) {
+  int start = X.col_ptrs[j];
+  nnz = X.col_ptrs[j + 1] - start;
+  if (rows != NULL) {
+    *rows = X.row_indices + start;
+  }
+  return X.values + start;
+}
+
+inline const double* dataCol(const arma::sp_mat& X, const int j, arma::vec& buf) {
+  int nnz;
+  const arma::uword* rows;
+  const double* x = sparseCol(X, j, nnz, &rows);
+  buf.zeros(X.n_rows);
+  for (int k = 0; k < nnz; k++) {
+    buf(rows[k]) = x[k];
+  }
+  return buf.memptr();
+}
+
+inline arma::vec dataColVec(const arma::sp_mat& X, const int j) {
+  arma::vec buf;
+  dataCol(X, j, buf);
+  return buf;
+}
+
+template <typename eT>
+arma::vec dataMeans(const arma::Mat<eT>& X) {
+  int n = X.n_rows, p = X.n_cols;
+  arma::vec rst(p), buf;
+  for (int j = 0; j < p; j++) {
+    const double* x = dataCol(X, j, buf);
+    rst(j) = arma::mean(arma::vec(const_cast<double*>(x), n, false, true));
+  }
+  return rst;
+}
+
+arma::vec dataMeans(const arma::sp_mat& X) {
+  int n = X.n_rows, p = X.n_cols, nnz;
+  arma::vec rst(p);
+  for (int j = 0; j < p; j++) {
+    const double* x = sparseCol(X, j, nnz);
+    double sum = 0;
+    for (int k = 0; k < nnz; k++) {
+      sum += x[k];
+    }
+    rst(j) = sum / n;
+  }
+  return rst;
+}
+
+// Huber means of the len columns of X from column first, and of their squares interleaved if second is not NULL.
+template <typename eT>
+void huberMeanBlock(const arma::Mat<eT>& X, const int first, const int len, double* mean, double* second, SolveInfo* infoMean, 
+                    SolveInfo* infoSecond, const double tol = 0.001, const int iteMax = 500) {
+  int n = X.n_rows, w = second != NULL ? 2 : 1, L = w * len;
+  std::vector<double> z((size_t)n * L), est(L);
+  std::vector<SolveInfo> info(L);
+  arma::vec buf;
+  for (int c = 0; c < len; c++) {
+    const double* x = dataCol(X, first + c, buf);
+    for (int i = 0; i < n; i++) {
+      z[(size_t)i * L + w * c] = x[i];
+      if (w == 2) {
+        z[(size_t)i * L + w * c + 1] = x[i] * x[i];
+      }
+    }
+  }
+  huberMeanLanes(z.data(), n, L, est.data(), info.data(), tol, iteMax);
+  for (int c = 0; c < len; c++) {
+    mean[c] = est[w * c];
+    infoMean[c] = info[w * c];
+    if (w == 2) {
+      second[c] = est[w * c + 1];
+      infoSecond[c] = info[w * c + 1];
+    }
+  }
+}
+
+// Sparse columns have different numbers of non-zeros, so they are solved one at a time over their non-zeros, with the
+// column and its square as two lanes and the zeros implicit
+void huberMeanBlock(const arma::sp_mat& X, const int first, const int len, double* mean, double* second, SolveInfo* infoMean, 
+                    SolveInfo* infoSecond, const double tol = 0.001, const int iteMax = 500) {
+  int n = X.n_rows, nnz;
+  for (int c = 0; c < len; c++) {
+    const double* x = sparseCol(X, first + c, nnz);
+    if (second != NULL) {
+      huberMeanSecondInfo(x, nnz, mean[c], second[c], infoMean + c, infoSecond + c, tol, iteMax, n - nnz);
+    } else {
+      huberMeanLanes(x, nnz, 1, mean + c, infoMean + c, tol, iteMax, n - nnz);
+    }
+  }
+}
+
+// Huber mean of the square of column j of X, whose values as doubles are x, for the variance estimators with known factors
+template <typename eT>
+double huberSecondCol(const arma::Mat<eT>& X, const int j, const arma::vec& x, SolveInfo* info) {
+  double second, dummy;
+  huberMeanSecondInfo(x.memptr(), X.n_rows, dummy, second, NULL, info);
+  return second;
+}
+
+double huberSecondCol(const arma::sp_mat& X, const int j, const arma::vec& x, SolveInfo* info) {
+  int nnz;
+  const double* v = sparseCol(X, j, nnz);
+  double second, dummy;
+  huberMeanSecondInfo(v, nnz, dummy, second, NULL, info, 0.001, 500, X.n_rows - nnz);
+  return second;
+}
+
+template <typename eT>
+arma::vec huberMeanVecInfo(const arma::Mat<eT>& X, const int n, const int p, FarmProfile& prof, const int slot, FarmMonitor& mon, 
+                           const double epsilon = 0.001, const int iteMax = 500) {
+  arma::vec rst(p);
+  SolveInfo info[HUBER_LANES];
+  for (int j = 0; j < p; j += HUBER_LANES) {
+    int len = std::min(HUBER_LANES, p - j);
+    huberMeanBlock(X, j, len, rst.memptr() + j, NULL, info, NULL, epsilon, iteMax);
+    for (int c = 0; c < len; c++) {
+      prof.record(slot, j + c, info[c]);
+    }
+    if (mon.tick(len)) {
+      break;
+    }
+  }
+  return rst;
+}
+
+// [[Rcpp::export]]
+arma::vec huberMeanVec(const arma::mat& X, const int n, const int p, const double epsilon = 0.001, const int iteMax = 500) {
+  FarmProfile prof(false);
+  FarmMonitor mon;
+  arma::vec rst = huberMeanVecInfo(X, n, p, prof, -1, mon, epsilon, iteMax);
+  mon.abort();
+  return rst;
+}
+
+// rootf2 for a sample of N values of which zeros are equal to 0 and not stored: resSq holds the squared residuals of the
+// others and zeroSq the one of the zeros
+double rootf2Zeros(const arma::vec& resSq, const int N, const int zeros, const double zeroSq, const double rhs, const double tol = 0.001, 
+                   const int maxIte = 500) {
+  int m = resSq.n_elem, ite = 0;
+  double low = m > 0 ? std::min(arma::min(resSq), zeroSq) : zeroSq, up = arma::accu(resSq) + zeros * zeroSq;
+  while (ite <= maxIte && up - low > tol) {
+    double mid = 0.5 * (up + low);
+    double val = (arma::accu(arma::min(resSq / mid, arma::ones(m))) + zeros * std::min(zeroSq / mid, 1.0)) / N - rhs;
+    if (val < 0) {
+      up = mid;
+    } else {
+      low = mid;
+    }
+    ite++;
+  }
+  return 0.5 * (low + up);
+}
+
+// Weighted mean of the fixed-point map of hMeanCov: tau is solved by rootf2 at mu, and G(mu) is the mean of Z with Huber
+// weights min(tau / |Z - mu|, 1). With zeros > 0, the sample has zeros more values equal to 0 that are not in Z.
+double hMeanCovMap(const arma::vec& Z, const double mu, const int n, const int d, const int N, const double rhs, const int zeros = 0) {
+  arma::vec res = Z - mu;
+  arma::vec resSq = arma::square(res);
+  if (zeros == 0) {
+    double tau = std::sqrt((long double)rootf2(resSq, n, d, N, rhs, arma::min(resSq), arma::accu(resSq)));
+    arma::vec w = arma::min(tau / arma::abs(res), arma::ones(N));
+    return arma::as_scalar(Z.t() * w) / arma::accu(w);
+  }
+  double tau = std::sqrt((long double)rootf2Zeros(resSq, N, zeros, mu * mu, rhs));
+  arma::vec w = arma::min(tau / arma::abs(res), arma::ones(N - zeros));
+  double w0 = tau < std::abs(mu) ? tau / std::abs(mu) : 1.0;
+  return arma::as_scalar(Z.t() * w) / (arma::accu(w) + zeros * w0);
+}
+
+// Fixed-point iteration for the Huber-type covariance entries, with secant acceleration if accel, started at init if
+// finite. With zeros > 0, Z holds only the non-zero values of the sample.
+double hMeanCovInfo(const arma::vec& Z, const int n, const int d, const int N, double rhs, SolveInfo* info, const double epsilon = 0.0001,
+                    const int iteMax = 500, const bool accel = true, const double init = arma::datum::nan, const int zeros = 0) {
+  double mu = zeros > 0 ? arma::accu(Z) / N : arma::mean(Z);
+  int iteNum = 0;
+  if (std::abs(mu) <= epsilon) {
+    info->ite = info->tau = 0;
+    info->conv = true;
+    return mu;
+  }
+  if (arma::is_finite(init)) {
+    mu = init;
+  }
+  double muNew = mu, r = 0, muPrev = 0, rPrev = 0;
+  bool secant = false;
+  while (iteNum < iteMax) {
+    muNew = hMeanCovMap(Z, mu, n, d, N, rhs, zeros);
+    r = muNew - mu;
+    iteNum++;
+    if (std::abs(r) <= epsilon) {
+      break;
+    }
+    double next = muNew;
+    if (accel && secant && std::abs(r) < std::abs(rPrev)) {
+      double beta = (mu - muPrev) / (rPrev - r);
+      if (beta >= 1 && beta <= 10) {
+        next = mu + beta * r;
+      }
+    }
+    muPrev = mu;
+    rPrev = r;
+    mu = next;
+    secant = true;
+  }
+  info->ite = iteNum;
+  info->tau = iteNum;
+  info->conv = std::abs(r) <= epsilon;
+  return muNew;
+}
+
+// [[Rcpp::export]]
+Rcpp::NumericVector hMeanCov(const arma::vec& Z, const int n, const int d, const int N, double rhs, const double epsilon = 0.0001, 
+                             const int iteMax = 500, const bool accel = true) {
+  SolveInfo info;
+  Rcpp::NumericVector rst = Rcpp::NumericVector::create(hMeanCovInfo(Z, n, d, N, rhs, &info, epsilon, iteMax, accel));
+  rst.attr("iterations") = info.ite;
+  return rst;
+}
+
+// Pairwise differences X_i - X_k, i < k, of a column, or with offsets > 0 only X_i - X_{i + s mod n}, s <= offsets.
+inline void pairDiffCol(const double* x, const int n, const int offsets, double* y) {
+  int k = 0;
+  if (offsets > 0) {
+    for (int s = 1; s <= offsets; s++) {
+      for (int i = 0; i < n; i++) {
+        y[k++] = x[i] - x[(i + s) % n];
+      }
+    }
+  } else {
+    for (int i = 0; i < n - 1; i++) {
+      for (int j = i + 1; j < n; j++) {
+        y[k++] = x[i] - x[j];
+      }
+    }
+  }
+}
+
+template <typename eT>
+arma::mat pairDiff(const arma::Mat<eT>& X, const int n, const int offsets = 0, const int first = 0, int len = -1) {
+  if (len < 0) {
+    len = X.n_cols;
+  }
+  int N = offsets > 0 ? n * offsets : n * (n - 1) >> 1;
+  arma::mat Y(N, len);
+  arma::vec buf;
+  for (int c = 0; c < len; c++) {
+    pairDiffCol(dataCol(X, first + c, buf), n, offsets, Y.colptr(c));
+  }
+  return Y;
+}
+
+// Huber means of the columns of X and the diagonal of the Huber-type covariance, written to mu and sigma
+template <typename MatT>
+void huberCovDiag(const MatT& X, const int n, const int p, arma::vec& mu, arma::vec& sigma, FarmProfile& prof, FarmMonitor& mon) {
+  const int C = HUBER_LANES / 2;
+  SolveInfo info[C], infoSecond[C];
+  double theta[C];
+  int slotMean = prof.addSlot("covMeans", p), slotSecond = prof.addSlot("covSecondMoments", p);
+  mon.begin("covDiagonal", p);
+  for (int j = 0; j < p && !mon.cancelled(); j += C) {
+    int len = std::min(C, p - j);
+    huberMeanBlock(X, j, len, mu.memptr() + j, theta, info, infoSecond);
+    for (int c = 0; c < len; c++) {
+      prof.record(slotMean, j + c, info[c]);
+      prof.record(slotSecond, j + c, infoSecond[c]);
+      double temp = mu(j + c) * mu(j + c);
+      if (theta[c] > temp) {
+        theta[c] -= temp;
+      }
+      sigma(j + c) = theta[c];
+    }
+    mon.tick(len);
   }
-  return 0.5 * (low + up);
+  mon.abort();
+  prof.stage("covDiagonal");
 }
 
-// [[Rcpp::export]]
-double f2(const double x, const arma::vec& resSq, const int N, const double rhs) {
-  return arma::mean(arma::min(resSq / x, arma::ones(N))) - rhs;
+// Entries (rowA + i, rowB + j) of sigmaHat from the pair differences of two blocks of columns; only j > i if same.
+double huberCovBlock(const arma::mat& YA, const arma::mat& YB, const int rowA, const int rowB, const bool same, const int n, const int d, 
+                     const int N, const double rhs2, arma::mat& sigmaHat, FarmProfile& prof, const int slot, const int first, 
+                     FarmMonitor& mon, const bool accel, const int threads, const arma::mat* start = NULL) {
+  int lenA = YA.n_cols, lenB = YB.n_cols;
+  double ite = 0;
+  #pragma omp parallel for schedule(dynamic) num_threads(threads) reduction(+:ite)
+  for (int i = 0; i < lenA; i++) {
+    if (mon.cancelled()) {
+      continue;
+    }
+    SolveInfo info;
+    int from = same ? i + 1 : 0;
+    for (int j = from; j < lenB; j++) {
+      double init = start != NULL ? (*start)(rowA + i, rowB + j) : arma::datum::nan;
+      sigmaHat(rowA + i, rowB + j) = sigmaHat(rowB + j, rowA + i) = hMeanCovInfo(0.5 * YA.col(i) % YB.col(j), n, d, N, rhs2, &info, 0.0001, 
+                                                                                 500, accel, init);
+      prof.record(slot, first + i, info);
+      ite += info.ite;
+    }
+    mon.tick(lenB - from);
+  }
+  return ite;
 }
 
-// [[Rcpp::export]]
-double rootf2(const arma::vec& resSq, const int n, const int d, const int N, const double rhs, double low, double up, const double tol = 0.001, 
-              const int maxIte = 500) {
-  int ite = 0;
-  while (ite <= maxIte && up - low > tol) {
-    double mid = 0.5 * (up + low);
-    double val = f2(mid, resSq, N, rhs);
-    if (val < 0) {
-      up = mid;
-    } else {
-      low = mid;
+// Huber-type covariance with d calibrating the off-diagonal tau, tiled by plan. Returns the total off-diagonal
+// iterations; start, if given, holds initial values of the entries.
+template <typename eT>
+double huberCovInfo(const arma::Mat<eT>& X, const int n, const int p, const int d, arma::vec& mu, arma::mat& sigmaHat, FarmProfile& prof, 
+                    FarmMonitor& mon, const bool accel = true, const FarmPlan& plan = FarmPlan(), const arma::mat* start = NULL) {
+  double rhs2 = (2 * std::log(d) + std::log(n)) / n;
+  mu.set_size(p);
+  sigmaHat.set_size(p, p);
+  arma::vec sigma(p);
+  huberCovDiag(X, n, p, mu, sigma, prof, mon);
+  sigmaHat.diag() = sigma;
+  int offsets = plan.pairOffsets(n);
+  int N = offsets > 0 ? n * offsets : n * (n - 1) >> 1;
+  int tile = plan.tile > 0 && plan.tile < p ? plan.tile : p;
+  int slotPair = prof.addSlot("covPairs", p);
+  double ite = 0;
+  mon.begin("covPairs", (long long)p * (p - 1) / 2);
+  for (int a = 0; a < p && !mon.cancelled(); a += tile) {
+    int lenA = std::min(tile, p - a);
+    arma::mat YA = pairDiff(X, n, offsets, a, lenA);
+    for (int b = a; b < p && !mon.cancelled(); b += tile) {
+      if (b == a) {
+        ite += huberCovBlock(YA, YA, a, a, true, n, d, N, rhs2, sigmaHat, prof, slotPair, a, mon, accel, plan.threads, start);
+      } else {
+        arma::mat YB = pairDiff(X, n, offsets, b, std::min(tile, p - b));
+        ite += huberCovBlock(YA, YB, a, b, false, n, d, N, rhs2, sigmaHat, prof, slotPair, a, mon, accel, plan.threads, start);
+      }
     }
-    ite++;
   }
-  return 0.5 * (low + up);
+  mon.abort();
+  prof.stage("covPairs");
+  return ite;
 }
 
-// [[Rcpp::export]]
-double g1(const double x, const arma::vec& resSq, const int n, const double rhs) {
-  return arma::mean(arma::min(resSq / x, arma::ones(n))) - rhs;
+// The pair products 0.5 (x_ia - x_ka)(x_ib - x_kb) of sparse columns a and b that can be non-zero; tag marks the rows
+// where only a, only b or both are non-zero by 1, 2 and 3.
+void sparsePairProducts(const double* xa, const double* xb, const std::vector<char>& tag, const std::vector<int>& rows, const int n, 
+                        const int offsets, std::vector<double>& Z) {
+  Z.clear();
+  for (size_t r = 0; r < rows.size(); r++) {
+    int u = rows[r];
+    if (tag[u] == 3 && offsets > 0) {
+      for (int s = 1; s <= offsets; s++) {
+        int k = (u + s) % n, l = (u - s % n + n) % n;
+        Z.push_back(0.5 * (xa[u] - xa[k]) * (xb[u] - xb[k]));
+        if (tag[l] != 3) {
+          Z.push_back(0.5 * (xa[u] - xa[l]) * (xb[u] - xb[l]));
+        }
+      }
+    } else if (tag[u] == 3) {
+      for (int k = 0; k < n; k++) {
+        if (k != u && (tag[k] != 3 || k > u)) {
+          Z.push_back(0.5 * (xa[u] - xa[k]) * (xb[u] - xb[k]));
+        }
+      }
+    } else if (tag[u] == 1 && offsets > 0) {
+      for (int s = 1; s <= offsets; s++) {
+        int k = (u + s) % n, l = (u - s % n + n) % n;
+        if (tag[k] == 2) {
+          Z.push_back(0.5 * (xa[u] - xa[k]) * (xb[u] - xb[k]));
+        }
+        if (tag[l] == 2) {
+          Z.push_back(0.5 * (xa[u] - xa[l]) * (xb[u] - xb[l]));
+        }
+      }
+    } else if (tag[u] == 1) {
+      for (size_t q = 0; q < rows.size(); q++) {
+        int k = rows[q];
+        if (tag[k] == 2) {
+          Z.push_back(0.5 * (xa[u] - xa[k]) * (xb[u] - xb[k]));
+        }
+      }
+    }
+  }
 }
 
-// [[Rcpp::export]]
-double rootg1(const arma::vec& resSq, const int n, const double rhs, double low, double up, const double tol = 0.001, const int maxIte = 500) {
-  int ite = 0;
-  while (ite <= maxIte && up - low > tol) {
-    double mid = 0.5 * (up + low);
-    double val = g1(mid, resSq, n, rhs);
-    if (val < 0) {
-      up = mid;
+// Column a of a sparse matrix expanded into xa, with its rows marked by 1 in tag, or cleared from both if load is false
+void sparseColLoad(const arma::sp_mat& X, const int a, std::vector<double>& xa, std::vector<char>& tag, const bool load) {
+  int nnz;
+  const arma::uword* rows;
+  const double* v = sparseCol(X, a, nnz, &rows);
+  for (int k = 0; k < nnz; k++) {
+    xa[rows[k]] = load ? v[k] : 0;
+    tag[rows[k]] = load ? 1 : 0;
+  }
+}
+
+// sparsePairProducts of column b and the column a loaded into xa and tag by sparseColLoad, which are left as they were
+void sparseColPair(const arma::sp_mat& X, const int a, const int b, const std::vector<double>& xa, std::vector<double>& xb, 
+                   std::vector<char>& tag, std::vector<int>& rows, const int n, const int offsets, std::vector<double>& Z) {
+  int nnzA, nnzB;
+  const arma::uword* rowsA;
+  const arma::uword* rowsB;
+  sparseCol(X, a, nnzA, &rowsA);
+  const double* vb = sparseCol(X, b, nnzB, &rowsB);
+  rows.assign(rowsA, rowsA + nnzA);
+  for (int k = 0; k < nnzB; k++) {
+    int r = rowsB[k];
+    xb[r] = vb[k];
+    if (tag[r] == 1) {
+      tag[r] = 3;
     } else {
-      low = mid;
+      tag[r] = 2;
+      rows.push_back(r);
     }
-    ite++;
   }
-  return 0.5 * (low + up);
+  sparsePairProducts(xa.data(), xb.data(), tag, rows, n, offsets, Z);
+  for (int k = 0; k < nnzB; k++) {
+    int r = rowsB[k];
+    xb[r] = 0;
+    tag[r] = tag[r] == 3 ? 1 : 0;
+  }
 }
 
-// [[Rcpp::export]]
-double huberDer(const arma::vec& res, const double tau, const int n) {
-  double rst = 0.0;
-  for (int i = 0; i < n; i++) {
-    double cur = res(i);
-    rst -= std::abs(cur) <= tau ? cur : tau * sgn(cur);
+// huberCovInfo for a sparse matrix, with the zero pair products left implicit in hMeanCovInfo.
+double huberCovInfo(const arma::sp_mat& X, const int n, const int p, const int d, arma::vec& mu, arma::mat& sigmaHat, FarmProfile& prof, 
+                    FarmMonitor& mon, const bool accel = true, const FarmPlan& plan = FarmPlan(), const arma::mat* start = NULL) {
+  double rhs2 = (2 * std::log(d) + std::log(n)) / n;
+  mu.set_size(p);
+  sigmaHat.set_size(p, p);
+  arma::vec sigma(p);
+  huberCovDiag(X, n, p, mu, sigma, prof, mon);
+  sigmaHat.diag() = sigma;
+  int offsets = plan.pairOffsets(n);
+  int N = offsets > 0 ? n * offsets : n * (n - 1) >> 1;
+  int slotPair = prof.addSlot("covPairs", p);
+  double ite = 0;
+  mon.begin("covPairs", (long long)p * (p - 1) / 2);
+  #pragma omp parallel num_threads(plan.threads) reduction(+:ite)
+  {
+    std::vector<double> xa(n, 0.0), xb(n, 0.0), Z;
+    std::vector<char> tag(n, 0);
+    std::vector<int> rows;
+    SolveInfo info;
+    #pragma omp for schedule(dynamic)
+    for (int a = 0; a < p - 1; a++) {
+      if (mon.cancelled()) {
+        continue;
+      }
+      sparseColLoad(X, a, xa, tag, true);
+      for (int b = a + 1; b < p; b++) {
+        sparseColPair(X, a, b, xa, xb, tag, rows, n, offsets, Z);
+        double init = start != NULL ? (*start)(a, b) : arma::datum::nan;
+        sigmaHat(a, b) = sigmaHat(b, a) = hMeanCovInfo(arma::vec(Z.data(), Z.size(), false, true), n, d, N, rhs2, &info, 0.0001, 500, 
+                                                       accel, init, N - (int)Z.size());
+        prof.record(slotPair, a, info);
+        ite += info.ite;
+      }
+      sparseColLoad(X, a, xa, tag, false);
+      mon.tick(p - 1 - a);
+    }
   }
-  return rst / n;
+  mon.abort();
+  prof.stage("covPairs");
+  return ite;
 }
 
 // [[Rcpp::export]]
-double huberMean(arma::vec X, const int n, const double tol = 0.001, const int iteMax = 500) {
-  double rhs = std::log(n) / n;
-  double mx = arma::mean(X);
-  X -= mx;
-  double tau = arma::stddev(X) * std::sqrt((long double)n / std::log(n));
-  double derOld = huberDer(X, tau, n);
-  double mu = -derOld, muDiff = -derOld;
-  arma::vec res = X - mu;
-  arma::vec resSq = arma::square(res);
-  tau = std::sqrt((long double)rootf1(resSq, n, rhs, arma::min(resSq), arma::accu(resSq)));
-  double derNew = huberDer(res, tau, n);
-  double derDiff = derNew - derOld;
-  int ite = 1;
-  while (std::abs(derNew) > tol && ite <= iteMax) {
-    double alpha = 1.0;
-    double cross = muDiff * derDiff;
-    if (cross > 0) {
-      double a1 = cross / derDiff * derDiff;
-      double a2 = muDiff * muDiff / cross;
-      alpha = std::min(std::min(a1, a2), 100.0);
+Rcpp::List huberCov(SEXP X, const int n, const int p, const int d = -1, const bool accel = true, 
+                    Rcpp::Nullable<Rcpp::List> plan = R_NilValue) {
+  FarmProfile prof(false);
+  FarmMonitor mon;
+  FarmPlan execPlan(plan);
+  // The estimates are written straight into the R vectors returned: the views already have the sizes huberCovInfo sets,
+  // so the p by p matrix is neither reallocated nor copied on the way out.
+  Rcpp::NumericVector means(p);
+  Rcpp::NumericMatrix cov(p, p);
+  arma::vec mu(means.begin(), p, false, true);
+  arma::mat sigmaHat(cov.begin(), p, p, false, true);
+  double ite;
+  if (Rf_isS4(X)) {
+    ite = huberCovInfo(Rcpp::as<arma::sp_mat>(X), n, p, d > 0 ? d : p, mu, sigmaHat, prof, mon, accel, execPlan);
+  } else if (TYPEOF(X) == INTSXP) {
+    Rcpp::IntegerMatrix x(X);
+    ite = huberCovInfo(arma::Mat<int>(x.begin(), n, p, false, true), n, p, d > 0 ? d : p, mu, sigmaHat, prof, mon, accel, execPlan);
+  } else {
+    Rcpp::NumericMatrix x(X);
+    ite = huberCovInfo(arma::mat(x.begin(), n, p, false, true), n, p, d > 0 ? d : p, mu, sigmaHat, prof, mon, accel, execPlan);
+  }
+  return Rcpp::List::create(Rcpp::Named("means") = means, Rcpp::Named("cov") = cov, Rcpp::Named("iterations") = ite);
+}
+
+// Enlarges the covariance sigma of X by the columns of XNew, estimating only the new diagonal and the new-by-old and
+// new-by-new blocks, tiled by plan.tile. sigma must come from the same offsets.
+double huberCovAppendInfo(const arma::mat& X, const arma::mat& XNew, const arma::mat& sigma, const int n, const int p, const int pNew, 
+                          const int d, arma::vec& mu, arma::mat& sigmaHat, FarmProfile& prof, FarmMonitor& mon, const bool accel = true, 
+                          const FarmPlan& plan = FarmPlan()) {
+  double rhs2 = (2 * std::log(d) + std::log(n)) / n;
+  sigmaHat.submat(0, 0, p - 1, p - 1) = sigma;
+  arma::vec sigmaNew(pNew);
+  huberCovDiag(XNew, n, pNew, mu, sigmaNew, prof, mon);
+  sigmaHat.submat(p, p, p + pNew - 1, p + pNew - 1).diag() = sigmaNew;
+  int offsets = plan.pairOffsets(n);
+  int N = offsets > 0 ? n * offsets : n * (n - 1) >> 1;
+  int tile = plan.tile > 0 && plan.tile < pNew ? plan.tile : pNew;
+  int slotPair = prof.addSlot("covPairs", pNew);
+  double ite = 0;
+  mon.begin("covPairs", (long long)pNew * p + (long long)pNew * (pNew - 1) / 2);
+  for (int a = 0; a < pNew && !mon.cancelled(); a += tile) {
+    arma::mat YA = pairDiff(XNew, n, offsets, a, std::min(tile, pNew - a));
+    for (int b = 0; b < p && !mon.cancelled(); b += tile) {
+      arma::mat YB = pairDiff(X, n, offsets, b, std::min(tile, p - b));
+      ite += huberCovBlock(YA, YB, p + a, b, false, n, d, N, rhs2, sigmaHat, prof, slotPair, a, mon, accel, plan.threads);
+    }
+    for (int b = 0; b <= a && !mon.cancelled(); b += tile) {
+      if (b == a) {
+        ite += huberCovBlock(YA, YA, p + a, p + a, true, n, d, N, rhs2, sigmaHat, prof, slotPair, a, mon, accel, plan.threads);
+      } else {
+        arma::mat YB = pairDiff(XNew, n, offsets, b, tile);
+        ite += huberCovBlock(YA, YB, p + a, p + b, false, n, d, N, rhs2, sigmaHat, prof, slotPair, a, mon, accel, plan.threads);
+      }
     }
-    derOld = derNew;
-    muDiff = -alpha * derNew;
-    mu += muDiff;
-    res = X - mu;
-    resSq = arma::square(res);
-    tau = std::sqrt((long double)rootf1(resSq, n, rhs, arma::min(resSq), arma::accu(resSq)));
-    derNew = huberDer(res, tau, n);
-    derDiff = derNew - derOld;
-    ite++;
   }
-  return mu + mx;
+  mon.abort();
+  prof.stage("covPairs");
+  return ite;
 }
 
 // [[Rcpp::export]]
-arma::vec huberMeanVec(const arma::mat& X, const int n, const int p, const double epsilon = 0.001, const int iteMax = 500) {
-  arma::vec rst(p);
-  for (int i = 0; i < p; i++) {
-    rst(i) = huberMean(X.col(i), n, epsilon, iteMax);
+Rcpp::List huberCovAppend(const arma::mat& X, const arma::mat& XNew, const arma::mat& sigma, const int n, const int p, const int pNew, 
+                          const int d = -1, const bool accel = true, Rcpp::Nullable<Rcpp::List> plan = R_NilValue) {
+  FarmProfile prof(false);
+  FarmMonitor mon;
+  int q = p + pNew;
+  Rcpp::NumericVector means(pNew);
+  Rcpp::NumericMatrix cov(q, q);
+  arma::vec mu(means.begin(), pNew, false, true);
+  arma::mat sigmaHat(cov.begin(), q, q, false, true);
+  double ite = huberCovAppendInfo(X, XNew, sigma, n, p, pNew, d > 0 ? d : q, mu, sigmaHat, prof, mon, accel, FarmPlan(plan));
+  return Rcpp::List::create(Rcpp::Named("means") = means, Rcpp::Named("cov") = cov, Rcpp::Named("iterations") = ite);
+}
+
+// The m by 2 matrix of 0-based pairs of columns of a sparsity pattern, as passed from R
+arma::umat patternPairs(const Rcpp::IntegerMatrix& pairs) {
+  int m = pairs.nrow();
+  arma::umat rst(m, 2);
+  for (int i = 0; i < m; i++) {
+    rst(i, 0) = pairs(i, 0);
+    rst(i, 1) = pairs(i, 1);
   }
   return rst;
 }
 
-// [[Rcpp::export]]
-double hMeanCov(const arma::vec& Z, const int n, const int d, const int N, double rhs, const double epsilon = 0.0001, const int iteMax = 500) {
-  double muOld = 0;
-  double muNew = arma::mean(Z);
-  double tau = arma::stddev(Z) * std::sqrt((long double)n / (2 * std::log(d) + std::log(n)));
-  int iteNum = 0;
-  arma::vec res(n), resSq(n), w(n);
-  while ((std::abs(muNew - muOld) > epsilon) && iteNum < iteMax) {
-    muOld = muNew;
-    res = Z - muOld;
-    resSq = arma::square(res);
-    tau = std::sqrt((long double)rootf2(resSq, n, d, N, rhs, arma::min(resSq), arma::accu(resSq)));
-    w = arma::min(tau / arma::abs(res), arma::ones(N));
-    muNew = arma::as_scalar(Z.t() * w) / arma::accu(w);
-    iteNum++;
+// The pairs of a pattern with a < b, sorted by a and then b, without duplicates and without pairs a == b, and the start
+// of each group of pairs with the same a in groups, followed by the number of pairs
+arma::umat patternGroups(const arma::umat& pattern, const int p, std::vector<int>& groups) {
+  std::vector<std::pair<arma::uword, arma::uword> > pairs;
+  for (arma::uword k = 0; k < pattern.n_rows; k++) {
+    arma::uword a = std::min(pattern(k, 0), pattern(k, 1)), b = std::max(pattern(k, 0), pattern(k, 1));
+    if (b >= (arma::uword)p) {
+      Rcpp::stop("The pattern refers to a column beyond the number of columns of X");
+    }
+    if (a != b) {
+      pairs.push_back(std::make_pair(a, b));
+    }
   }
-  return muNew;
+  std::sort(pairs.begin(), pairs.end());
+  pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+  int m = pairs.size();
+  arma::umat rst(m, 2);
+  groups.clear();
+  for (int k = 0; k < m; k++) {
+    rst(k, 0) = pairs[k].first;
+    rst(k, 1) = pairs[k].second;
+    if (k == 0 || rst(k, 0) != rst(k - 1, 0)) {
+      groups.push_back(k);
+    }
+  }
+  groups.push_back(m);
+  return rst;
 }
 
-// [[Rcpp::export]]
-Rcpp::List huberCov(const arma::mat& X, const int n, const int p) {
-  double rhs2 = (2 * std::log(p) + std::log(n)) / n;
-  arma::vec mu(p);
-  arma::mat sigmaHat(p, p);
+// The sparse p by p estimate with diagonal sigma and the entries value of the pairs on both sides of the diagonal
+arma::sp_mat patternMatrix(const arma::umat& pairs, const arma::vec& value, const arma::vec& sigma, const int p) {
+  int m = pairs.n_rows;
+  arma::umat locations(2, p + 2 * m);
+  arma::vec values(p + 2 * m);
   for (int j = 0; j < p; j++) {
-    mu(j) = huberMean(X.col(j), n);
-    double theta = huberMean(arma::square(X.col(j)), n);
-    double temp = mu(j) * mu(j);
-    if (theta > temp) {
-      theta -= temp;
-    }
-    sigmaHat(j, j) = theta;
+    locations(0, j) = locations(1, j) = j;
+    values(j) = sigma(j);
+  }
+  for (int k = 0; k < m; k++) {
+    locations(0, p + 2 * k) = locations(1, p + 2 * k + 1) = pairs(k, 0);
+    locations(1, p + 2 * k) = locations(0, p + 2 * k + 1) = pairs(k, 1);
+    values(p + 2 * k) = values(p + 2 * k + 1) = value(k);
   }
-  int N = n * (n - 1) >> 1;
-  arma::mat Y(N, p);
-  for (int i = 0, k = 0; i < n - 1; i++) {
-    for (int j = i + 1; j < n; j++) {
-      Y.row(k++) = X.row(i) - X.row(j);
+  return arma::sp_mat(locations, values, p, p);
+}
+
+// Huber-type covariance restricted to the diagonal and the pairs of pattern, as a sparse p by p matrix.
+template <typename eT>
+double huberCovPatternInfo(const arma::Mat<eT>& X, const int n, const int p, const int d, const arma::umat& pattern, arma::vec& mu, 
+                           arma::sp_mat& sigmaHat, FarmProfile& prof, FarmMonitor& mon, const bool accel = true, 
+                           const FarmPlan& plan = FarmPlan()) {
+  double rhs2 = (2 * std::log(d) + std::log(n)) / n;
+  mu.set_size(p);
+  arma::vec sigma(p);
+  huberCovDiag(X, n, p, mu, sigma, prof, mon);
+  std::vector<int> groups;
+  arma::umat pairs = patternGroups(pattern, p, groups);
+  int m = pairs.n_rows, G = groups.size() - 1;
+  int offsets = plan.pairOffsets(n);
+  int N = offsets > 0 ? n * offsets : n * (n - 1) >> 1;
+  int slotPair = prof.addSlot("covPairs", p);
+  arma::vec value(m);
+  double ite = 0;
+  mon.begin("covPairs", m);
+  #pragma omp parallel num_threads(plan.threads) reduction(+:ite)
+  {
+    arma::vec bufA, bufB, ya(N), yb(N);
+    SolveInfo info;
+    #pragma omp for schedule(dynamic)
+    for (int g = 0; g < G; g++) {
+      if (mon.cancelled()) {
+        continue;
+      }
+      int a = pairs(groups[g], 0);
+      pairDiffCol(dataCol(X, a, bufA), n, offsets, ya.memptr());
+      for (int k = groups[g]; k < groups[g + 1]; k++) {
+        pairDiffCol(dataCol(X, pairs(k, 1), bufB), n, offsets, yb.memptr());
+        value(k) = hMeanCovInfo(0.5 * ya % yb, n, d, N, rhs2, &info, 0.0001, 500, accel);
+        prof.record(slotPair, a, info);
+        ite += info.ite;
+      }
+      mon.tick(groups[g + 1] - groups[g]);
     }
   }
-  for (int i = 0; i < p - 1; i++) {
-    for (int j = i + 1; j < p; j++) {
-      sigmaHat(i, j) = sigmaHat(j, i) = hMeanCov(0.5 * Y.col(i) % Y.col(j), n, p, N, rhs2);
+  mon.abort();
+  sigmaHat = patternMatrix(pairs, value, sigma, p);
+  prof.stage("covPairs");
+  return ite;
+}
+
+// huberCovPatternInfo for a sparse matrix, with the pair products of sparseColPair as in huberCovInfo
+double huberCovPatternInfo(const arma::sp_mat& X, const int n, const int p, const int d, const arma::umat& pattern, arma::vec& mu, 
+                           arma::sp_mat& sigmaHat, FarmProfile& prof, FarmMonitor& mon, const bool accel = true, 
+                           const FarmPlan& plan = FarmPlan()) {
+  double rhs2 = (2 * std::log(d) + std::log(n)) / n;
+  mu.set_size(p);
+  arma::vec sigma(p);
+  huberCovDiag(X, n, p, mu, sigma, prof, mon);
+  std::vector<int> groups;
+  arma::umat pairs = patternGroups(pattern, p, groups);
+  int m = pairs.n_rows, G = groups.size() - 1;
+  int offsets = plan.pairOffsets(n);
+  int N = offsets > 0 ? n * offsets : n * (n - 1) >> 1;
+  int slotPair = prof.addSlot("covPairs", p);
+  arma::vec value(m);
+  double ite = 0;
+  mon.begin("covPairs", m);
+  #pragma omp parallel num_threads(plan.threads) reduction(+:ite)
+  {
+    std::vector<double> xa(n, 0.0), xb(n, 0.0), Z;
+    std::vector<char> tag(n, 0);
+    std::vector<int> rows;
+    SolveInfo info;
+    #pragma omp for schedule(dynamic)
+    for (int g = 0; g < G; g++) {
+      if (mon.cancelled()) {
+        continue;
+      }
+      int a = pairs(groups[g], 0);
+      sparseColLoad(X, a, xa, tag, true);
+      for (int k = groups[g]; k < groups[g + 1]; k++) {
+        sparseColPair(X, a, pairs(k, 1), xa, xb, tag, rows, n, offsets, Z);
+        value(k) = hMeanCovInfo(arma::vec(Z.data(), Z.size(), false, true), n, d, N, rhs2, &info, 0.0001, 500, accel, arma::datum::nan, 
+                                N - (int)Z.size());
+        prof.record(slotPair, a, info);
+        ite += info.ite;
+      }
+      sparseColLoad(X, a, xa, tag, false);
+      mon.tick(groups[g + 1] - groups[g]);
     }
   }
-  return Rcpp::List::create(Rcpp::Named("means") = mu, Rcpp::Named("cov") = sigmaHat);
+  mon.abort();
+  sigmaHat = patternMatrix(pairs, value, sigma, p);
+  prof.stage("covPairs");
+  return ite;
+}
+
+// [[Rcpp::export]]
+Rcpp::List huberCovPattern(SEXP X, const int n, const int p, const Rcpp::IntegerMatrix& pairs, const int d = -1, 
+                           const bool accel = true, Rcpp::Nullable<Rcpp::List> plan = R_NilValue) {
+  FarmProfile prof(false);
+  FarmMonitor mon;
+  FarmPlan execPlan(plan);
+  arma::vec mu;
+  arma::sp_mat sigmaHat;
+  double ite;
+  if (Rf_isS4(X)) {
+    ite = huberCovPatternInfo(Rcpp::as<arma::sp_mat>(X), n, p, d > 0 ? d : p, patternPairs(pairs), mu, sigmaHat, prof, mon, accel, 
+                              execPlan);
+  } else if (TYPEOF(X) == INTSXP) {
+    Rcpp::IntegerMatrix x(X);
+    ite = huberCovPatternInfo(arma::Mat<int>(x.begin(), n, p, false, true), n, p, d > 0 ? d : p, patternPairs(pairs), mu, sigmaHat, 
+                              prof, mon, accel, execPlan);
+  } else {
+    Rcpp::NumericMatrix x(X);
+    ite = huberCovPatternInfo(arma::mat(x.begin(), n, p, false, true), n, p, d > 0 ? d : p, patternPairs(pairs), mu, sigmaHat, prof, 
+                              mon, accel, execPlan);
+  }
+  return Rcpp::List::create(Rcpp::Named("means") = mu, Rcpp::Named("cov") = sigmaHat, Rcpp::Named("iterations") = ite);
 }
 
 // [[Rcpp::export]]
@@ -201,148 +1786,215 @@ void updateHuber(const arma::mat& Z, const arma::vec& res, arma::vec& der, arma:
   grad = n1 * Z.t() * der;
 }
 
-// [[Rcpp::export]]
-arma::vec adaHuberReg(const arma::mat& X, arma::vec Y, const int n, const int p, const double tol = 0.0001, const int iteMax = 5000) {
-  const double n1 = 1.0 / n;
-  double rhs = n1 * (p + std::log(n * p));
-  arma::rowvec mx = arma::mean(X, 0);
-  arma::vec sx = arma::stddev(X, 0, 0).t();
-  double my = arma::mean(Y);
-  arma::mat Z = arma::join_rows(arma::ones(n), standardize(X, mx, sx, p));
-  Y -= my;
-  double tau = 1.345 * mad(Y);
-  arma::vec der(n);
-  arma::vec gradOld(p + 1), gradNew(p + 1);
-  updateHuber(Z, Y, der, gradOld, n, tau, n1);
-  arma::vec beta = -gradOld, betaDiff = -gradOld;
-  arma::vec res = Y - Z * beta;
-  arma::vec resSq = arma::square(res);
-  tau = std::sqrt((long double)rootg1(resSq, n, rhs, arma::min(resSq), arma::accu(resSq)));
-  updateHuber(Z, res, der, gradNew, n, tau, n1);
-  arma::vec gradDiff = gradNew - gradOld;
-  int ite = 1;
-  while (arma::norm(gradNew, "inf") > tol && ite <= iteMax) {
-    double alpha = 1.0;
-    double cross = arma::as_scalar(betaDiff.t() * gradDiff);
-    if (cross > 0) {
-      double a1 = cross / arma::as_scalar(gradDiff.t() * gradDiff);
-      double a2 = arma::as_scalar(betaDiff.t() * betaDiff) / cross;
-      alpha = std::min(std::min(a1, a2), 100.0);
+// Tau rules of the Huber regression kernel. MadTau uses constTau times the mad of the current residuals as in huberReg,
+// and AdaptiveTau starts from 1.345 * mad(Y) and then solves the tuning-free equation of adaHuberReg with rootg1.
+struct MadTau {
+  double constTau;
+  MadTau(const double c) : constTau(c) {}
+  double init(const arma::vec& Y) const {
+    return constTau * mad(Y);
+  }
+  double operator()(const arma::vec& res, const int n) const {
+    return constTau * mad(res);
+  }
+};
+
+struct AdaptiveTau {
+  double rhs;
+  AdaptiveTau(const int n, const int p) : rhs((p + std::log(n * p)) / n) {}
+  double init(const arma::vec& Y) const {
+    return 1.345 * mad(Y);
+  }
+  double operator()(const arma::vec& res, const int n) const {
+    arma::vec resSq = arma::square(res);
+    return std::sqrt((long double)rootg1(resSq, n, rhs, arma::min(resSq), arma::accu(resSq)));
+  }
+};
+
+// Output rules of the Huber regression kernel: all coefficients, only the slopes, or only the intercept.
+struct RegFull {
+  typedef arma::vec type;
+  static type get(arma::vec& beta, const arma::mat& X, const arma::vec& Y, const double my, const arma::vec& sx, const int n, const int p, 
+                  SolveInfo* info) {
+    beta.rows(1, p) /= sx;
+    SolveInfo itcpInfo;
+    beta(0) = huberMeanInfo(Y + my - X * beta.rows(1, p), n, &itcpInfo);
+    info->tau += itcpInfo.tau;
+    return beta;
+  }
+};
+
+struct RegCoef {
+  typedef arma::vec type;
+  static type get(arma::vec& beta, const arma::mat& X, const arma::vec& Y, const double my, const arma::vec& sx, const int n, const int p, 
+                  SolveInfo* info) {
+    return beta.rows(1, p) / sx;
+  }
+};
+
+struct RegItcp {
+  typedef double type;
+  static type get(arma::vec& beta, const arma::mat& X, const arma::vec& Y, const double my, const arma::vec& sx, const int n, const int p, 
+                  SolveInfo* info) {
+    SolveInfo itcpInfo;
+    double itcp = huberMeanInfo(Y + my - X * (beta.rows(1, p) / sx), n, &itcpInfo);
+    info->tau += itcpInfo.tau;
+    return itcp;
+  }
+};
+
+// Semismooth Newton iterations for Huber regression. Returns false if a step fails, leaving a valid iterate for
+// gradient descent to continue from.
+template <typename TauRule>
+bool huberNewton(const arma::mat& Z, arma::vec& beta, arma::vec& betaDiff, arma::vec& res, arma::vec& der, arma::vec& gradNew, 
+                 arma::vec& gradDiff, double& tau, const TauRule& tauRule, const int n, const double n1, const double tol, int& ite, 
+                 int& tauExtra, const int newtonMax) {
+  arma::uvec inside = arma::abs(res) <= tau;
+  arma::mat Zin = Z.rows(arma::find(inside));
+  arma::mat H = n1 * Zin.t() * Zin;
+  arma::mat R;
+  while (arma::norm(gradNew, "inf") > tol && ite <= newtonMax) {
+    if (!arma::chol(R, H)) {
+      return false;
+    }
+    arma::vec step = -arma::solve(arma::trimatu(R), arma::solve(arma::trimatl(R.t()), gradNew));
+    arma::vec gradOld = gradNew;
+    double normOld = arma::norm(gradOld, "inf");
+    bool accepted = false;
+    for (int k = 0; k < 10 && !accepted; k++) {
+      arma::vec resTrial = res - Z * step;
+      double tauTrial = tauRule(resTrial, n);
+      tauExtra += k > 0;
+      updateHuber(Z, resTrial, der, gradNew, n, tauTrial, n1);
+      if (arma::norm(gradNew, "inf") < normOld) {
+        beta += step;
+        betaDiff = step;
+        res = resTrial;
+        tau = tauTrial;
+        gradDiff = gradNew - gradOld;
+        accepted = true;
+      } else {
+        step *= 0.5;
+      }
+    }
+    if (!accepted) {
+      gradNew = gradOld;
+      return false;
     }
-    gradOld = gradNew;
-    betaDiff = -alpha * gradNew;
-    beta += betaDiff;
-    res -= Z * betaDiff;
-    resSq = arma::square(res);
-    tau = std::sqrt((long double)rootg1(resSq, n, rhs, arma::min(resSq), arma::accu(resSq)));
-    updateHuber(Z, res, der, gradNew, n, tau, n1);
-    gradDiff = gradNew - gradOld;
     ite++;
+    arma::uvec insideNew = arma::abs(res) <= tau;
+    arma::uvec flip = arma::find(insideNew != inside);
+    if (4 * flip.n_elem < (arma::uword)n) {
+      for (arma::uword i = 0; i < flip.n_elem; i++) {
+        arma::rowvec z = Z.row(flip(i));
+        H += (insideNew(flip(i)) ? n1 : -n1) * z.t() * z;
+      }
+    } else {
+      Zin = Z.rows(arma::find(insideNew));
+      H = n1 * Zin.t() * Zin;
+    }
+    inside = insideNew;
   }
-  beta.rows(1, p) /= sx;
-  beta(0) = huberMean(Y + my - X * beta.rows(1, p), n);
-  return beta;
+  return arma::norm(gradNew, "inf") <= tol;
 }
 
-// [[Rcpp::export]]
-arma::vec huberReg(const arma::mat& X, arma::vec Y, const int n, const int p, const double tol = 0.0001, const double constTau = 1.345, 
-                   const int iteMax = 5000) {
-  const double n1 = 1.0 / n;
-  arma::rowvec mx = arma::mean(X, 0);
-  arma::vec sx = arma::stddev(X, 0, 0).t();
-  double my = arma::mean(Y);
-  arma::mat Z = arma::join_rows(arma::ones(n), standardize(X, mx, sx, p));
-  Y -= my;
-  double tau = constTau * mad(Y);
-  arma::vec der(n);
-  arma::vec gradOld(p + 1), gradNew(p + 1);
-  updateHuber(Z, Y, der, gradOld, n, tau, n1);
-  arma::vec beta = -gradOld, betaDiff = -gradOld;
-  arma::vec res = Y - Z * beta;
-  tau = constTau * mad(res);
-  updateHuber(Z, res, der, gradNew, n, tau, n1);
-  arma::vec gradDiff = gradNew - gradOld;
-  int ite = 1;
-  while (arma::norm(gradNew, "inf") > tol && ite <= iteMax) {
-    double alpha = 1.0;
-    double cross = arma::as_scalar(betaDiff.t() * gradDiff);
-    if (cross > 0) {
-      double a1 = cross / arma::as_scalar(gradDiff.t() * gradDiff);
-      double a2 = arma::as_scalar(betaDiff.t() * betaDiff) / cross;
-      alpha = std::min(std::min(a1, a2), 100.0);
-    }
-    gradOld = gradNew;
-    betaDiff = -alpha * gradNew;
-    beta += betaDiff;
-    res -= Z * betaDiff;
-    tau = constTau * mad(res);
-    updateHuber(Z, res, der, gradNew, n, tau, n1);
-    gradDiff = gradNew - gradOld;
-    ite++;
+inline int gcd(int a, int b) {
+  while (b != 0) {
+    int t = a % b;
+    a = b;
+    b = t;
   }
-  beta.rows(1, p) /= sx;
-  beta(0) = huberMean(Y + my - X * beta.rows(1, p), n);
-  return beta;
+  return a;
 }
 
-// [[Rcpp::export]]
-arma::vec huberRegCoef(const arma::mat& X, arma::vec Y, const int n, const int p, const double tol = 0.0001, const double constTau = 1.345, 
-                       const int iteMax = 5000) {
-  const double n1 = 1.0 / n;
-  arma::rowvec mx = arma::mean(X, 0);
-  arma::vec sx = arma::stddev(X, 0, 0).t();
-  double my = arma::mean(Y);
-  arma::mat Z = arma::join_rows(arma::ones(n), standardize(X, mx, sx, p));
-  Y -= my;
-  double tau = constTau * mad(Y);
-  arma::vec der(n);
-  arma::vec gradOld(p + 1), gradNew(p + 1);
-  updateHuber(Z, Y, der, gradOld, n, tau, n1);
-  arma::vec beta = -gradOld, betaDiff = -gradOld;
-  arma::vec res = Y - Z * beta;
-  tau = constTau * mad(res);
-  updateHuber(Z, res, der, gradNew, n, tau, n1);
-  arma::vec gradDiff = gradNew - gradOld;
-  int ite = 1;
-  while (arma::norm(gradNew, "inf") > tol && ite <= iteMax) {
-    double alpha = 1.0;
-    double cross = arma::as_scalar(betaDiff.t() * gradDiff);
-    if (cross > 0) {
-      double a1 = cross / arma::as_scalar(gradDiff.t() * gradDiff);
-      double a2 = arma::as_scalar(betaDiff.t() * betaDiff) / cross;
-      alpha = std::min(std::min(a1, a2), 100.0);
+// Preconditioned SVRG epochs for Huber regression on tall designs. Returns false if Z^T Z is singular or the epochs do
+// not converge, leaving a snapshot for gradient descent to continue from.
+template <typename TauRule>
+bool huberSvrg(const arma::mat& Z, arma::vec& beta, arma::vec& betaDiff, arma::vec& res, arma::vec& der, arma::vec& gradNew, 
+               arma::vec& gradDiff, double& tau, const TauRule& tauRule, const int n, const double n1, const double tol, int& ite, 
+               const int epochMax) {
+  const int q = Z.n_cols, chunk = 64, perBatch = 4;
+  int nChunk = (n + chunk - 1) / chunk;
+  arma::mat P;
+  if (!arma::inv_sympd(P, n1 * Z.t() * Z)) {
+    return false;
+  }
+  double levMax = arma::max(arma::sum((Z * P) % Z, 1));
+  const double eta = 0.5 / (1 + levMax / (chunk * perBatch));
+  int stride = (int)(0.6180339887 * nChunk) | 1;
+  while (gcd(stride, nChunk) != 1) {
+    stride += 2;
+  }
+  arma::vec corr(q), delta(q), diff(chunk);
+  while (arma::norm(gradNew, "inf") > tol && ite <= epochMax) {
+    arma::vec betaSnap = beta;
+    long long pos = 0;
+    for (int c = 0; c < nChunk; c += perBatch) {
+      delta = beta - betaSnap;
+      corr.zeros();
+      int len = 0;
+      for (int k = 0; k < perBatch && c + k < nChunk; k++) {
+        int first = (int)(pos % nChunk) * chunk, m = std::min(chunk, n - first);
+        pos += stride;
+        for (int i = 0; i < m; i++) {
+          diff(i) = res(first + i);
+        }
+        for (int j = 0; j < q; j++) {
+          const double* z = Z.colptr(j) + first;
+          for (int i = 0; i < m; i++) {
+            diff(i) -= z[i] * delta(j);
+          }
+        }
+        for (int i = 0; i < m; i++) {
+          diff(i) = -der(first + i) - std::min(std::max(diff(i), -tau), tau);
+        }
+        for (int j = 0; j < q; j++) {
+          const double* z = Z.colptr(j) + first;
+          double s = 0;
+          for (int i = 0; i < m; i++) {
+            s += diff(i) * z[i];
+          }
+          corr(j) += s;
+        }
+        len += m;
+      }
+      beta -= eta * P * (gradNew + corr / len);
     }
-    gradOld = gradNew;
-    betaDiff = -alpha * gradNew;
-    beta += betaDiff;
+    arma::vec gradOld = gradNew;
+    betaDiff = beta - betaSnap;
     res -= Z * betaDiff;
-    tau = constTau * mad(res);
+    tau = tauRule(res, n);
     updateHuber(Z, res, der, gradNew, n, tau, n1);
     gradDiff = gradNew - gradOld;
     ite++;
   }
-  return beta.rows(1, p) / sx;
+  return arma::norm(gradNew, "inf") <= tol;
 }
 
-// [[Rcpp::export]]
-double huberRegItcp(const arma::mat& X, arma::vec Y, const int n, const int p, const double tol = 0.0001, const double constTau = 1.345, 
-                       const int iteMax = 5000) {
+// Huber regression kernel: gradient descent with Barzilai-Borwein steps, preceded by Newton or SVRG as set by solver.
+template <typename TauRule, typename Output>
+typename Output::type huberRegKernel(const arma::mat& X, arma::vec Y, const int n, const int p, const TauRule& tauRule, SolveInfo* info, 
+                                     const double tol, const int iteMax, const HuberSolver solver) {
   const double n1 = 1.0 / n;
   arma::rowvec mx = arma::mean(X, 0);
   arma::vec sx = arma::stddev(X, 0, 0).t();
   double my = arma::mean(Y);
   arma::mat Z = arma::join_rows(arma::ones(n), standardize(X, mx, sx, p));
   Y -= my;
-  double tau = constTau * mad(Y);
+  double tau = tauRule.init(Y);
   arma::vec der(n);
   arma::vec gradOld(p + 1), gradNew(p + 1);
   updateHuber(Z, Y, der, gradOld, n, tau, n1);
   arma::vec beta = -gradOld, betaDiff = -gradOld;
   arma::vec res = Y - Z * beta;
-  tau = constTau * mad(res);
+  tau = tauRule(res, n);
   updateHuber(Z, res, der, gradNew, n, tau, n1);
   arma::vec gradDiff = gradNew - gradOld;
-  int ite = 1;
+  int ite = 1, tauExtra = 0;
+  info->newton = solver == SOLVER_NEWTON && huberNewton(Z, beta, betaDiff, res, der, gradNew, gradDiff, tau, tauRule, n, n1, tol, ite, 
+                                                        tauExtra, std::min(iteMax, 100));
+  info->svrg = solver == SOLVER_SVRG && huberSvrg(Z, beta, betaDiff, res, der, gradNew, gradDiff, tau, tauRule, n, n1, tol, ite, 
+                                                  std::min(iteMax, 100));
   while (arma::norm(gradNew, "inf") > tol && ite <= iteMax) {
     double alpha = 1.0;
     double cross = arma::as_scalar(betaDiff.t() * gradDiff);
@@ -355,13 +2007,69 @@ double huberRegItcp(const arma::mat& X, arma::vec Y, const int n, const int p, c
     betaDiff = -alpha * gradNew;
     beta += betaDiff;
     res -= Z * betaDiff;
-    tau = constTau * mad(res);
+    tau = tauRule(res, n);
     updateHuber(Z, res, der, gradNew, n, tau, n1);
     gradDiff = gradNew - gradOld;
     ite++;
   }
-  beta.rows(1, p) /= sx;
-  return huberMean(Y + my - X * beta.rows(1, p), n);
+  info->ite = ite - 1;
+  info->tau = ite + 1 + tauExtra;
+  info->conv = arma::norm(gradNew, "inf") <= tol;
+  return Output::get(beta, X, Y, my, sx, n, p, info);
+}
+
+arma::vec adaHuberRegInfo(const arma::mat& X, const arma::vec& Y, const int n, const int p, SolveInfo* info, const double tol = 0.0001, 
+                          const int iteMax = 5000, const HuberSolver solver = SOLVER_GD) {
+  return huberRegKernel<AdaptiveTau, RegFull>(X, Y, n, p, AdaptiveTau(n, p), info, tol, iteMax, solver);
+}
+
+// [[Rcpp::export]]
+Rcpp::NumericVector adaHuberReg(const arma::mat& X, const arma::vec& Y, const int n, const int p, const double tol = 0.0001, 
+                                const int iteMax = 5000, const int solver = 0) {
+  SolveInfo info;
+  Rcpp::NumericVector rst = Rcpp::wrap(adaHuberRegInfo(X, Y, n, p, &info, tol, iteMax, huberSolver(solver)));
+  rst.attr("iterations") = info.ite;
+  rst.attr("solver") = info.solver();
+  return rst;
+}
+
+arma::vec huberRegInfo(const arma::mat& X, const arma::vec& Y, const int n, const int p, SolveInfo* info, const double tol = 0.0001, 
+                       const double constTau = 1.345, const int iteMax = 5000, const HuberSolver solver = SOLVER_GD) {
+  return huberRegKernel<MadTau, RegFull>(X, Y, n, p, MadTau(constTau), info, tol, iteMax, solver);
+}
+
+// [[Rcpp::export]]
+Rcpp::NumericVector huberReg(const arma::mat& X, const arma::vec& Y, const int n, const int p, const double tol = 0.0001, 
+                             const double constTau = 1.345, const int iteMax = 5000, const int solver = 0) {
+  SolveInfo info;
+  Rcpp::NumericVector rst = Rcpp::wrap(huberRegInfo(X, Y, n, p, &info, tol, constTau, iteMax, huberSolver(solver)));
+  rst.attr("iterations") = info.ite;
+  rst.attr("solver") = info.solver();
+  return rst;
+}
+
+arma::vec huberRegCoefInfo(const arma::mat& X, const arma::vec& Y, const int n, const int p, SolveInfo* info, const double tol = 0.0001, 
+                           const double constTau = 1.345, const int iteMax = 5000, const HuberSolver solver = SOLVER_GD) {
+  return huberRegKernel<MadTau, RegCoef>(X, Y, n, p, MadTau(constTau), info, tol, iteMax, solver);
+}
+
+// [[Rcpp::export]]
+arma::vec huberRegCoef(const arma::mat& X, const arma::vec& Y, const int n, const int p, const double tol = 0.0001, 
+                       const double constTau = 1.345, const int iteMax = 5000, const int solver = 0) {
+  SolveInfo info;
+  return huberRegCoefInfo(X, Y, n, p, &info, tol, constTau, iteMax, huberSolver(solver));
+}
+
+double huberRegItcpInfo(const arma::mat& X, const arma::vec& Y, const int n, const int p, SolveInfo* info, const double tol = 0.0001, 
+                        const double constTau = 1.345, const int iteMax = 5000, const HuberSolver solver = SOLVER_GD) {
+  return huberRegKernel<MadTau, RegItcp>(X, Y, n, p, MadTau(constTau), info, tol, iteMax, solver);
+}
+
+// [[Rcpp::export]]
+double huberRegItcp(const arma::mat& X, const arma::vec& Y, const int n, const int p, const double tol = 0.0001, 
+                    const double constTau = 1.345, const int iteMax = 5000, const int solver = 0) {
+  SolveInfo info;
+  return huberRegItcpInfo(X, Y, n, p, &info, tol, constTau, iteMax, huberSolver(solver));
 }
 
 // [[Rcpp::export]]
@@ -393,206 +2101,848 @@ arma::vec getPboot(const arma::vec& mu, const arma::mat& boot, const arma::vec&
       rst(i) = arma::accu(boot.row(i) >= 2 * mu(i) - h0(i));
     }
   }
-  return rst / B;
+  return rst / B;
+}
+
+// Bootstrap p-values of getPboot from exceedance counts updated replicate by replicate; the replicates are kept if
+// keep.
+class BootCounter {
+private:
+  arma::vec mu, bound, count;
+  int type;
+  bool keep;
+  Rcpp::NumericMatrix reps;
+  int p, B, b;
+
+public:
+  BootCounter(const arma::vec& mean, const arma::vec& h0, const std::string& alternative, const int p, const int B, const bool keepBoot)
+    : mu(mean), count(arma::zeros(p)), keep(keepBoot), p(p), B(B), b(0) {
+    if (alternative == "two.sided") {
+      type = 0;
+      bound = arma::abs(mu - h0);
+    } else {
+      type = alternative == "less" ? 1 : 2;
+      bound = 2 * mu - h0;
+    }
+    if (keep) {
+      reps = Rcpp::NumericMatrix(p, B);
+    }
+  }
+
+  void add(const arma::vec& rep) {
+    if (type == 0) {
+      count += arma::conv_to<arma::vec>::from(arma::abs(rep - mu) >= bound);
+    } else if (type == 1) {
+      count += arma::conv_to<arma::vec>::from(rep <= bound);
+    } else {
+      count += arma::conv_to<arma::vec>::from(rep >= bound);
+    }
+    if (keep) {
+      std::copy(rep.begin(), rep.end(), reps.begin() + (size_t)p * b);
+    }
+    b++;
+  }
+
+  int size() const {
+    return b;
+  }
+
+  arma::vec pValues() const {
+    return count / b;
+  }
+
+  // The p by b matrix of the replicates so far; only a cancelled run returns a copy of its first b columns.
+  SEXP replicates() const {
+    if (b == B) {
+      return reps;
+    }
+    Rcpp::NumericMatrix rst(p, b);
+    std::copy(reps.begin(), reps.begin() + (size_t)p * b, rst.begin());
+    return rst;
+  }
+};
+
+// Storey-adjusted p-values min(P * piHat * p / rank, 1) with the ranks from one sort.
+// [[Rcpp::export]]
+arma::vec adjust(const arma::vec& Prob, const double alpha, const int p, const int threads = 1) {
+  double piHat = std::min((double)arma::accu(Prob > alpha) / (p * (1 - alpha)), 1.0);
+  arma::uvec idx = arma::sort_index(Prob);
+  arma::vec rst(p);
+  #pragma omp parallel for num_threads(threads)
+  for (int k = 0; k < p; k++) {
+    arma::uword i = idx(k);
+    rst(i) = std::min(Prob(i) * piHat * p / (k + 1), 1.0);
+  }
+  return rst;
+}
+
+// Bin of a p-value in the histogram path of the FDR adjustment: the leading 20 bits of its single precision representation,
+// which are monotone in the value and give a relative resolution of 2^-11 for all p-values above 1e-38
+const arma::uword P_BINS = (0x3F800000u >> 12) + 1;
+
+inline arma::uword pBin(const double x) {
+  float f = (float)x;
+  uint32_t bits;
+  std::memcpy(&bits, &f, sizeof(bits));
+  return std::min((arma::uword)(bits >> 12), P_BINS - 1);
+}
+
+// Adds a chunk of p-values to the histogram counts, which start as an empty vector
+// [[Rcpp::export]]
+arma::vec pHistAdd(const arma::vec& P, arma::vec counts) {
+  if (counts.n_elem != P_BINS) {
+    counts = arma::zeros(P_BINS);
+  }
+  for (arma::uword i = 0; i < P.n_elem; i++) {
+    counts(pBin(P(i)))++;
+  }
+  return counts;
 }
 
+// Storey-adjusted values of a chunk of p-values, with ranks bounded from below by the histogram counts.
 // [[Rcpp::export]]
-arma::vec adjust(const arma::vec& Prob, const double alpha, const int p) {
-  double piHat = std::min((double)arma::accu(Prob > alpha) / (p * (1 - alpha)), 1.0);
-  arma::uvec rk = arma::sort_index(arma::sort_index(Prob)) + 1;
-  return arma::min(Prob * piHat * p / rk, arma::ones(p));
+arma::vec adjustHist(const arma::vec& P, const arma::vec& counts, const double piHat, const double p) {
+  arma::vec below = arma::cumsum(counts) - counts;
+  int m = P.n_elem;
+  arma::vec rst(m);
+  for (int i = 0; i < m; i++) {
+    rst(i) = std::min(P(i) * piHat * p / (below(pBin(P(i))) + 1), 1.0);
+  }
+  return rst;
+}
+
+// Number of leading eigenvalue ratios of the eigenvalue ratio estimator of the number of factors
+int ratioLength(const int n, const int p) {
+  int temp = std::min(n, p);
+  return temp < 4 ? temp - 1 : temp >> 1;
 }
 
+// The eigenvalues are in ascending order and may be only the leading ones, as long as there are at least
+// ratioLength(n, p) + 1 of them.
 // [[Rcpp::export]]
 arma::vec getRatio(const arma::vec& eigenVal, const int n, const int p) {
-  int temp = std::min(n, p);
-  int len = temp < 4 ? temp - 1 : temp >> 1;
+  int len = ratioLength(n, p), m = eigenVal.n_elem;
   if (len == 0) {
     arma::vec rst(1);
-    rst(0) = eigenVal(p - 1);
+    rst(0) = eigenVal(m - 1);
     return rst;
   }
   arma::vec ratio(len);
-  double comp = eigenVal(p - 1) / eigenVal(p - 2);
+  double comp = eigenVal(m - 1) / eigenVal(m - 2);
   ratio(0) = comp;
   for (int i = 1; i < len; i++) {
-    ratio(i) = eigenVal(p - 1 - i) / eigenVal(p - 2 - i);
+    ratio(i) = eigenVal(m - 1 - i) / eigenVal(m - 2 - i);
   }
   return ratio;
 }
 
+// The k leading eigenpairs of S in ascending order, by subspace iteration on S + cI from a deterministic start block,
+// or from the columns of start if given.
+template <typename MatS>
+void eigenTop(const MatS& S, const int k, arma::vec& eigenVal, arma::mat& eigenVec, SolveInfo* info, const double tol = 1e-10, 
+              const int iteMax = 1000, const arma::mat* start = NULL) {
+  int p = S.n_rows, q = std::min(p, k + 10);
+  double c = 0;
+  for (int j = 0; j < p; j++) {
+    double s = S(j, j);
+    c = std::max(c, arma::accu(arma::abs(S.col(j))) - s - std::abs(s));
+  }
+  arma::mat V(p, q);
+  int m = start != NULL && (int)start->n_rows == p ? std::min((int)start->n_cols, q) : 0;
+  if (m > 0) {
+    V.head_cols(m) = start->head_cols(m);
+  }
+  for (int j = m; j < q; j++) {
+    for (int i = 0; i < p; i++) {
+      V(i, j) = std::sin((i + 1.0) * (j + 1.0));
+    }
+  }
+  arma::mat Q, R, W, H, U;
+  arma::qr_econ(Q, R, V);
+  arma::vec theta, thetaOld = arma::zeros(k);
+  int ite = 0;
+  bool conv = false;
+  while (ite < iteMax) {
+    W = S * Q;
+    H = Q.t() * W;
+    arma::eig_sym(theta, U, 0.5 * (H + H.t()));
+    ite++;
+    arma::vec top = theta.tail(k);
+    if (ite > 1 && arma::max(arma::abs(top - thetaOld)) <= tol * std::max(std::abs(theta(q - 1)), 1.0)) {
+      conv = true;
+      break;
+    }
+    thetaOld = top;
+    arma::qr_econ(Q, R, W * U + c * Q * U);
+  }
+  eigenVal = theta.tail(k);
+  eigenVec = Q * U.tail_cols(k);
+  info->ite = ite;
+  info->tau = 0;
+  info->conv = conv;
+}
+
+// Eigenpairs of sigmaHat in ascending order, only the k leading ones if plan.nEigen > 0 or warm is given.
+void factorEigen(const arma::mat& sigmaHat, const int k, const FarmPlan& plan, FarmProfile& prof, arma::vec& eigenVal, 
+                 arma::mat& eigenVec, const arma::mat* warm = NULL) {
+  if ((plan.nEigen > 0 || warm != NULL) && k < (int)sigmaHat.n_rows) {
+    SolveInfo info;
+    eigenTop(sigmaHat, k, eigenVal, eigenVec, &info, 1e-10, 1000, warm);
+    prof.record(prof.addSlot("eigen", 1), 0, info);
+  } else {
+    arma::eig_sym(eigenVal, eigenVec, sigmaHat);
+  }
+  prof.stage("eigen");
+}
+
+// Eigen stage for a covariance restricted to a sparsity pattern, whose leading eigenpairs are always found by subspace
+// iteration on the sparse matrix
+void factorEigen(const arma::sp_mat& sigmaHat, const int k, const FarmPlan& plan, FarmProfile& prof, arma::vec& eigenVal, 
+                 arma::mat& eigenVec, const arma::mat* warm = NULL) {
+  if (k < (int)sigmaHat.n_rows) {
+    SolveInfo info;
+    eigenTop(sigmaHat, k, eigenVal, eigenVec, &info, 1e-10, 1000, warm);
+    prof.record(prof.addSlot("eigen", 1), 0, info);
+  } else {
+    arma::eig_sym(eigenVal, eigenVec, arma::mat(sigmaHat));
+  }
+  prof.stage("eigen");
+}
+
+// The p by K loadings of the K leading eigenpairs, with the eigenvalues in ascending order
+arma::mat topLoadings(const arma::vec& eigenVal, const arma::mat& eigenVec, const int K) {
+  int m = eigenVal.n_elem;
+  arma::mat B(eigenVec.n_rows, K);
+  for (int i = 1; i <= K; i++) {
+    double lambda = std::sqrt((long double)std::max(eigenVal(m - i), 0.0));
+    B.col(i - 1) = lambda * eigenVec.col(m - i);
+  }
+  return B;
+}
+
+// Eigenvalues, eigenvalue ratios, number of factors if K <= 0 and p by K loadings of sigmaHat, warm-started from *warm.
+template <typename MatS>
+arma::mat factorLoadings(const MatS& sigmaHat, const int n, const int p, int& K, const FarmPlan& plan, FarmProfile& prof, 
+                         arma::vec& eigenVal, arma::vec& ratio, arma::mat* warm = NULL) {
+  arma::mat eigenVec;
+  factorEigen(sigmaHat, std::max(plan.nEigen, K > 0 ? K : ratioLength(n, p) + 1), plan, prof, eigenVal, eigenVec, warm);
+  if (K <= 0) {
+    ratio = getRatio(eigenVal, n, p);
+    K = arma::index_max(ratio) + 1;
+  }
+  arma::mat B = topLoadings(eigenVal, eigenVec, K);
+  if (warm != NULL) {
+    warm->swap(eigenVec);
+  }
+  return B;
+}
+
+// Plan of farm.test for an n by p sample: predicted memory and flops per stage, and the cheapest FarmPlan whose peak
+// memory stays below memory bytes (no cap if memory <= 0).
 // [[Rcpp::export]]
-Rcpp::List rmTest(const arma::mat& X, const arma::vec& h0, const double alpha = 0.05, const std::string alternative = "two.sided") {
+Rcpp::List farmPlan(const double n, const double p, const int K = -1, const bool covariance = true, const int B = 0, 
+                    const bool keepBoot = false, const double memory = -1, int threads = 1) {
+# ifdef _OPENMP
+  threads = std::max(threads, 1);
+# else
+  threads = 1;
+# endif
+  double cap = memory > 0 ? memory : arma::datum::inf;
+  double input = 8 * n * p;
+  std::vector<std::string> stages;
+  std::vector<double> mem, ops;
+  int tile = 0, offsets = 0, nEigen = 0;
+  double nPairs = 0;
+  bool keep = keepBoot, feasible = true;
+  if (covariance) {
+    double sigma = 8 * p * p;
+    stages.push_back("covDiagonal");
+    mem.push_back(sigma + 16 * p);
+    ops.push_back(80 * n * p);
+    double avail = cap - input - sigma, m = n * (n - 1) / 2, t = p;
+    if (8 * (m * p + 5 * m * threads) > avail) {
+      t = std::floor((avail / 8 - 5 * m * threads) / (2 * m));
+      if (t < 1) {
+        double L = std::min(std::floor(avail / 8 / (n * (2 + 5 * threads))), std::floor((n - 1) / 2));
+        if (L < 1) {
+          feasible = false;
+          L = 1;
+        }
+        offsets = (int)L;
+        m = n * L;
+        t = std::max(std::floor((avail / 8 - 5 * m * threads) / (2 * m)), 1.0);
+      }
+      tile = t >= p ? 0 : (int)t;
+    }
+    nPairs = m;
+    double blocks = tile > 0 ? std::ceil(p / tile) : 1;
+    stages.push_back("covPairs");
+    mem.push_back(sigma + 8 * ((tile > 0 ? 2 * m * tile : m * p) + 5 * m * threads));
+    ops.push_back(280 * m * p * (p - 1) / 2 + m * p * blocks);
+    int k = K > 0 ? K : ratioLength((int)n, (int)p) + 1;
+    double q = std::min(p, k + 10.0);
+    double fullMem = sigma + 24 * p * p, fullOps = 9 * p * p * p, partMem = sigma + 32 * p * q, partOps = 200 * p * p * q;
+    if (k < p && (partOps < fullOps || input + fullMem > cap)) {
+      nEigen = k;
+    }
+    stages.push_back("eigen");
+    mem.push_back(nEigen > 0 ? partMem : fullMem);
+    ops.push_back(nEigen > 0 ? partOps : fullOps);
+  } else {
+    stages.push_back("estimate");
+    mem.push_back(16 * p);
+    ops.push_back(80 * n * p);
+    if (B > 0) {
+      double boot = 8 * (n / 2 * p + 3 * p);
+      if (keep && input + boot + 8 * p * B > cap) {
+        keep = false;
+      }
+      stages.push_back("bootstrap");
+      mem.push_back(boot + (keep ? 8 * p * B : 0));
+      ops.push_back(40 * B * n / 2 * p);
+    }
+  }
+  double peak = input + *std::max_element(mem.begin(), mem.end()), work = 0;
+  for (size_t i = 0; i < ops.size(); i++) {
+    work += ops[i];
+  }
+  feasible = feasible && peak <= cap;
+  return Rcpp::List::create(Rcpp::Named("tile") = tile, Rcpp::Named("offsets") = offsets, Rcpp::Named("nEigen") = nEigen, 
+                            Rcpp::Named("threads") = threads, Rcpp::Named("keepBoot") = keep, Rcpp::Named("nPairs") = nPairs, 
+                            Rcpp::Named("feasible") = feasible, Rcpp::Named("memory") = peak, Rcpp::Named("work") = work, 
+                            Rcpp::Named("stage") = stages, Rcpp::Named("stageMemory") = mem, Rcpp::Named("stageWork") = ops);
+}
+
+// Result of a one-sample test with normal approximation, kept as plain Armadillo objects so that the test cores can run
+// on worker threads; toList() converts it on the master thread, with loadings and eigenvalues only when they were computed.
+struct FarmResult {
+  arma::vec mu, sigma, T, Prob, pAdjust, eigenVal, ratio, meanBound;
+  arma::uvec significant;
+  arma::mat B;
+  int K;
+  bool hasEigen;
+  FarmResult() : K(0), hasEigen(false) {}
+
+  void test(const arma::vec& h0, const double alpha, const std::string& alternative) {
+    T = (mu - h0) / sigma;
+    Prob = getP(T, alternative);
+    pAdjust = adjust(Prob, alpha, Prob.n_elem);
+    significant = pAdjust <= alpha;
+  }
+
+  Rcpp::List toList() const {
+    Rcpp::List rst = Rcpp::List::create(Rcpp::Named("means") = mu, Rcpp::Named("stdDev") = sigma);
+    if (K > 0) {
+      rst.push_back(B, "loadings");
+      rst.push_back(K, "nfactors");
+    }
+    rst.push_back(T, "tStat");
+    rst.push_back(Prob, "pValues");
+    rst.push_back(pAdjust, "pAdjust");
+    rst.push_back(significant, "significant");
+    if (hasEigen) {
+      rst.push_back(eigenVal, "eigens");
+      rst.push_back(ratio, "ratio");
+    }
+    if (!meanBound.is_empty()) {
+      rst.push_back(meanBound, "meanBounds");
+    }
+    return rst;
+  }
+};
+
+template <typename MatT>
+void rmTestCore(const MatT& X, const arma::vec& h0, const double alpha, const std::string& alternative, FarmProfile& prof, 
+                FarmMonitor& mon, FarmResult& rst, const int bins = 0) {
   int n = X.n_rows, p = X.n_cols;
+  int slotMean = prof.addSlot("means", p), slotSecond = prof.addSlot("secondMoments", p);
+  const int C = HUBER_LANES / 2;
+  SolveInfo info[C], infoSecond[C];
   arma::vec mu(p), sigma(p);
-  for (int j = 0; j < p; j++) {
-    mu(j) = huberMean(X.col(j), n);
-    double theta = huberMean(arma::square(X.col(j)), n);
-    double temp = mu(j) * mu(j);
-    if (theta > temp) {
-      theta -= temp;
+  mon.begin("estimate", p);
+  if (bins > 0) {
+    arma::vec buf, xSq(n);
+    rst.meanBound.set_size(p);
+    for (int j = 0; j < p && !mon.tick(); j++) {
+      const double* x = dataCol(X, j, buf);
+      for (int i = 0; i < n; i++) {
+        xSq(i) = x[i] * x[i];
+      }
+      mu(j) = huberMeanBinnedInfo(x, n, bins, &rst.meanBound(j), &info[0]);
+      sigma(j) = huberMeanBinnedInfo(xSq.memptr(), n, bins, NULL, &infoSecond[0]);
+      prof.record(slotMean, j, info[0]);
+      prof.record(slotSecond, j, infoSecond[0]);
+      double temp = mu(j) * mu(j);
+      if (sigma(j) > temp) {
+        sigma(j) -= temp;
+      }
+    }
+  } else {
+    for (int j = 0; j < p && !mon.cancelled(); j += C) {
+      int len = std::min(C, p - j);
+      huberMeanBlock(X, j, len, mu.memptr() + j, sigma.memptr() + j, info, infoSecond);
+      for (int c = 0; c < len; c++) {
+        prof.record(slotMean, j + c, info[c]);
+        prof.record(slotSecond, j + c, infoSecond[c]);
+        double temp = mu(j + c) * mu(j + c);
+        if (sigma(j + c) > temp) {
+          sigma(j + c) -= temp;
+        }
+      }
+      mon.tick(len);
     }
-    sigma(j) = theta;
   }
-  sigma = arma::sqrt(sigma / n);
-  arma::vec T = (mu - h0) / sigma;
-  arma::vec Prob = getP(T, alternative);
-  arma::vec pAdjust = adjust(Prob, alpha, p);
-  arma::uvec significant = pAdjust <= alpha;
-  return Rcpp::List::create(Rcpp::Named("means") = mu, Rcpp::Named("stdDev") = sigma, Rcpp::Named("tStat") = T, Rcpp::Named("pValues") = Prob, 
-                            Rcpp::Named("pAdjust") = pAdjust, Rcpp::Named("significant") = significant);
+  mon.abort();
+  prof.stage("estimate");
+  rst.mu = mu;
+  rst.sigma = arma::sqrt(sigma / n);
+  rst.test(h0, alpha, alternative);
+  prof.stage("testing");
 }
 
 // [[Rcpp::export]]
-Rcpp::List rmTestBoot(const arma::mat& X, const arma::vec& h0, const double alpha = 0.05, const std::string alternative = "two.sided", 
-                      const int B = 500) {
+Rcpp::List rmTest(SEXP X, const arma::vec& h0, const double alpha = 0.05, const std::string alternative = "two.sided", 
+                  const bool profile = false, Rcpp::Nullable<Rcpp::Function> progress = R_NilValue, const int bins = 0) {
+  FarmProfile prof(profile);
+  FarmMonitor mon(progress);
+  FarmResult rst;
+  if (Rf_isS4(X)) {
+    rmTestCore(Rcpp::as<arma::sp_mat>(X), h0, alpha, alternative, prof, mon, rst, bins);
+  } else if (TYPEOF(X) == INTSXP) {
+    Rcpp::IntegerMatrix x(X);
+    rmTestCore(arma::Mat<int>(x.begin(), x.nrow(), x.ncol(), false, true), h0, alpha, alternative, prof, mon, rst, bins);
+  } else {
+    Rcpp::NumericMatrix x(X);
+    rmTestCore(arma::mat(x.begin(), x.nrow(), x.ncol(), false, true), h0, alpha, alternative, prof, mon, rst, bins);
+  }
+  Rcpp::List rstList = rst.toList();
+  if (profile) {
+    rstList.push_back(prof.toList(), "profile");
+  }
+  return rstList;
+}
+
+template <typename eT>
+Rcpp::List rmTestBootData(const arma::Mat<eT>& X, const arma::vec& h0, const double alpha, const std::string& alternative, const int B, 
+                          const bool profile, Rcpp::Nullable<Rcpp::Function> progress, const bool partial, const bool keepBoot) {
   int n = X.n_rows, p = X.n_cols;
-  arma::vec mu = huberMeanVec(X, n, p);
-  arma::mat boot(p, B);
-  for (int i = 0; i < B; i++) {
+  FarmProfile prof(profile);
+  FarmMonitor mon(progress);
+  mon.begin("estimate", p);
+  arma::vec mu = huberMeanVecInfo(X, n, p, prof, prof.addSlot("means", p), mon);
+  mon.abort();
+  prof.stage("estimate");
+  int slotBoot = prof.addSlot("bootstrap", p);
+  BootCounter boot(mu, h0, alternative, p, B, keepBoot);
+  mon.begin("bootstrap", (long long)B * p);
+  while (boot.size() < B && !mon.cancelled()) {
     arma::uvec idx = arma::find(arma::randi(n, arma::distr_param(0, 1)) == 1);
     int subn = idx.size();
-    arma::mat subX = X.rows(idx);
-    boot.col(i) = huberMeanVec(subX, subn, p);
+    arma::Mat<eT> subX = X.rows(idx);
+    arma::vec rep = huberMeanVecInfo(subX, subn, p, prof, slotBoot, mon);
+    if (mon.cancelled()) {
+      break;
+    }
+    boot.add(rep);
+  }
+  if (!partial || boot.size() == 0) {
+    mon.abort();
   }
-  arma::vec Prob = getPboot(mu, boot, h0, alternative, p, B);
+  prof.stage("bootstrap");
+  arma::vec Prob = boot.pValues();
   arma::vec pAdjust = adjust(Prob, alpha, p);
   arma::uvec significant = pAdjust <= alpha;
-  return Rcpp::List::create(Rcpp::Named("means") = mu, Rcpp::Named("pValues") = Prob, Rcpp::Named("pAdjust") = pAdjust, 
-                            Rcpp::Named("significant") = significant);
+  prof.stage("testing");
+  Rcpp::List rst = Rcpp::List::create(Rcpp::Named("means") = mu, Rcpp::Named("pValues") = Prob, Rcpp::Named("pAdjust") = pAdjust, 
+                                      Rcpp::Named("significant") = significant);
+  if (mon.cancelled()) {
+    rst.push_back(true, "interrupted");
+    rst.push_back(boot.size(), "nBoot");
+  }
+  if (keepBoot) {
+    rst.push_back(boot.replicates(), "bootstrap");
+  }
+  if (profile) {
+    rst.push_back(prof.toList(), "profile");
+  }
+  return rst;
+}
+
+// [[Rcpp::export]]
+Rcpp::List rmTestBoot(SEXP X, const arma::vec& h0, const double alpha = 0.05, const std::string alternative = "two.sided", const int B = 500, 
+                      const bool profile = false, Rcpp::Nullable<Rcpp::Function> progress = R_NilValue, const bool partial = false, 
+                      const bool keepBoot = false) {
+  if (TYPEOF(X) == INTSXP) {
+    Rcpp::IntegerMatrix x(X);
+    return rmTestBootData(arma::Mat<int>(x.begin(), x.nrow(), x.ncol(), false, true), h0, alpha, alternative, B, profile, progress, 
+                          partial, keepBoot);
+  }
+  Rcpp::NumericMatrix x(X);
+  return rmTestBootData(arma::mat(x.begin(), x.nrow(), x.ncol(), false, true), h0, alpha, alternative, B, profile, progress, partial, 
+                        keepBoot);
 }
 
 // [[Rcpp::export]]
 Rcpp::List rmTestTwo(const arma::mat& X, const arma::mat& Y, const arma::vec& h0, const double alpha = 0.05, 
-                     const std::string alternative = "two.sided") {
+                     const std::string alternative = "two.sided", const bool profile = false, 
+                     Rcpp::Nullable<Rcpp::Function> progress = R_NilValue) {
   int nX = X.n_rows, nY = Y.n_rows, p = X.n_cols;
+  FarmProfile prof(profile);
+  FarmMonitor mon(progress);
+  int slotMeanX = prof.addSlot("X.means", p), slotMeanY = prof.addSlot("Y.means", p);
+  int slotSecondX = prof.addSlot("X.secondMoments", p), slotSecondY = prof.addSlot("Y.secondMoments", p);
+  SolveInfo info, infoSecond;
   arma::vec muX(p), sigmaX(p), muY(p), sigmaY(p);
-  for (int j = 0; j < p; j++) {
-    muX(j) = huberMean(X.col(j), nX);
-    muY(j) = huberMean(Y.col(j), nY);
-    double theta = huberMean(arma::square(X.col(j)), nX);
+  mon.begin("estimate", p);
+  for (int j = 0; j < p && !mon.tick(); j++) {
+    double theta;
+    huberMeanSecondInfo(X.colptr(j), nX, muX(j), theta, &info, &infoSecond);
+    prof.record(slotMeanX, j, info);
+    prof.record(slotSecondX, j, infoSecond);
     double temp = muX(j) * muX(j);
     if (theta > temp) {
       theta -= temp;
     }
     sigmaX(j) = theta;
-    theta = huberMean(arma::square(Y.col(j)), nY);
+    huberMeanSecondInfo(Y.colptr(j), nY, muY(j), theta, &info, &infoSecond);
+    prof.record(slotMeanY, j, info);
+    prof.record(slotSecondY, j, infoSecond);
     temp = muY(j) * muY(j);
     if (theta > temp) {
       theta -= temp;
     }
     sigmaY(j) = theta;
   }
+  mon.abort();
+  prof.stage("estimate");
   arma::vec T = (muX - muY - h0) / arma::sqrt(sigmaX / nX + sigmaY / nY);
   sigmaX = arma::sqrt(sigmaX / nX);
   sigmaY = arma::sqrt(sigmaY / nY);
   arma::vec Prob = getP(T, alternative);
   arma::vec pAdjust = adjust(Prob, alpha, p);
   arma::uvec significant = pAdjust <= alpha;
-  return Rcpp::List::create(Rcpp::Named("meansX") = muX, Rcpp::Named("meansY") = muY, Rcpp::Named("stdDevX") = sigmaX, 
-                            Rcpp::Named("stdDevY") = sigmaY, Rcpp::Named("tStat") = T, Rcpp::Named("pValues") = Prob, 
-                            Rcpp::Named("pAdjust") = pAdjust, Rcpp::Named("significant") = significant);
+  prof.stage("testing");
+  Rcpp::List rst = Rcpp::List::create(Rcpp::Named("meansX") = muX, Rcpp::Named("meansY") = muY, Rcpp::Named("stdDevX") = sigmaX, 
+                                      Rcpp::Named("stdDevY") = sigmaY, Rcpp::Named("tStat") = T, Rcpp::Named("pValues") = Prob, 
+                                      Rcpp::Named("pAdjust") = pAdjust, Rcpp::Named("significant") = significant);
+  if (profile) {
+    rst.push_back(prof.toList(), "profile");
+  }
+  return rst;
 }
 
 // [[Rcpp::export]]
 Rcpp::List rmTestTwoBoot(const arma::mat& X, const arma::mat& Y, const arma::vec& h0, const double alpha = 0.05, 
-                         const std::string alternative = "two.sided", const int B = 500) {
+                         const std::string alternative = "two.sided", const int B = 500, const bool profile = false, 
+                         Rcpp::Nullable<Rcpp::Function> progress = R_NilValue, const bool partial = false, 
+                         const bool keepBoot = false) {
   int nX = X.n_rows, nY = Y.n_rows, p = X.n_cols;
-  arma::vec muX = huberMeanVec(X, nX, p);
-  arma::vec muY = huberMeanVec(Y, nY, p);
-  arma::mat bootX(p, B), bootY(p, B);
-  for (int i = 0; i < B; i++) {
+  FarmProfile prof(profile);
+  FarmMonitor mon(progress);
+  mon.begin("estimate", 2 * p);
+  arma::vec muX = huberMeanVecInfo(X, nX, p, prof, prof.addSlot("X.means", p), mon);
+  arma::vec muY = huberMeanVecInfo(Y, nY, p, prof, prof.addSlot("Y.means", p), mon);
+  mon.abort();
+  prof.stage("estimate");
+  int slotBootX = prof.addSlot("X.bootstrap", p), slotBootY = prof.addSlot("Y.bootstrap", p);
+  BootCounter boot(muX - muY, h0, alternative, p, B, keepBoot);
+  mon.begin("bootstrap", (long long)B * p * 2);
+  while (boot.size() < B && !mon.cancelled()) {
     arma::uvec idx = arma::find(arma::randi(nX, arma::distr_param(0, 1)) == 1);
     int subn = idx.size();
     arma::mat subX = X.rows(idx);
-    bootX.col(i) = huberMeanVec(subX, subn, p);
+    arma::vec rep = huberMeanVecInfo(subX, subn, p, prof, slotBootX, mon);
     idx = arma::find(arma::randi(nY, arma::distr_param(0, 1)) == 1);
     subn = idx.size();
     arma::mat subY = Y.rows(idx);
-    bootY.col(i) = huberMeanVec(subY, subn, p);
+    rep -= huberMeanVecInfo(subY, subn, p, prof, slotBootY, mon);
+    if (mon.cancelled()) {
+      break;
+    }
+    boot.add(rep);
   }
-  arma::vec Prob = getPboot(muX - muY, bootX - bootY, h0, alternative, p, B);
+  if (!partial || boot.size() == 0) {
+    mon.abort();
+  }
+  prof.stage("bootstrap");
+  arma::vec Prob = boot.pValues();
   arma::vec pAdjust = adjust(Prob, alpha, p);
   arma::uvec significant = pAdjust <= alpha;
-  return Rcpp::List::create(Rcpp::Named("meansX") = muX, Rcpp::Named("meansY") = muY, Rcpp::Named("pValues") = Prob, 
-                            Rcpp::Named("pAdjust") = pAdjust, Rcpp::Named("significant") = significant);
+  prof.stage("testing");
+  Rcpp::List rst = Rcpp::List::create(Rcpp::Named("meansX") = muX, Rcpp::Named("meansY") = muY, Rcpp::Named("pValues") = Prob, 
+                                      Rcpp::Named("pAdjust") = pAdjust, Rcpp::Named("significant") = significant);
+  if (mon.cancelled()) {
+    rst.push_back(true, "interrupted");
+    rst.push_back(boot.size(), "nBoot");
+  }
+  if (keepBoot) {
+    rst.push_back(boot.replicates(), "bootstrap");
+  }
+  if (profile) {
+    rst.push_back(prof.toList(), "profile");
+  }
+  return rst;
 }
 
-// [[Rcpp::export]]
-Rcpp::List farmTest(const arma::mat& X, const arma::vec& h0, int K = -1, const double alpha = 0.05, const std::string alternative = "two.sided") {
+// Factor adjustment and test of one-sample FarmTest with unknown factors, from the sample means xMean, Huber means mu and
+// Huber variances sigma of the columns and the p by K loadings B. With K = 0 it is the robust test without factors.
+void farmTestAdjust(const arma::vec& xMean, const int n, const arma::vec& h0, const arma::vec& mu, arma::vec sigma, const arma::mat& B, 
+                    const double alpha, const std::string& alternative, const HuberSolver solver, FarmProfile& prof, FarmResult& rst) {
+  int p = B.n_rows, K = B.n_cols;
+  rst.mu = mu;
+  if (K > 0) {
+    SolveInfo info;
+    arma::vec f = huberRegCoefInfo(B, xMean, p, K, &info, 0.0001, 1.345, 5000, solver);
+    prof.record(prof.addSlot("factorRegression", 1), 0, info);
+    prof.stage("factorRegression");
+    for (int j = 0; j < p; j++) {
+      double temp = arma::norm(B.row(j), 2);
+      if (sigma(j) > temp * temp) {
+        sigma(j) -= temp * temp;
+      }
+    }
+    rst.mu -= B * f;
+  }
+  rst.sigma = arma::sqrt(sigma / n);
+  rst.B = B;
+  rst.K = K;
+  rst.test(h0, alpha, alternative);
+  prof.stage("testing");
+}
+
+// State carried by farmTestRoll from one window to the next: the Huber-type covariance, whose entries start the fixed-point
+// iterations of the next window, and the leading eigenvectors, which start its subspace iteration.
+struct FarmWarm {
+  arma::mat sigmaHat, eigenVec;
+};
+
+template <typename MatT>
+void farmTestCore(const MatT& X, const arma::vec& h0, int K, const double alpha, const std::string& alternative, const HuberSolver solver, 
+                  FarmProfile& prof, FarmMonitor& mon, FarmResult& rst, const FarmPlan& plan = FarmPlan(), FarmWarm* warm = NULL, 
+                  const arma::umat* pattern = NULL) {
   int n = X.n_rows, p = X.n_cols;
-  Rcpp::List listCov = huberCov(X, n, p);
-  arma::vec mu = listCov["means"];
-  arma::mat sigmaHat = listCov["cov"];
+  arma::vec mu, sigma, eigenVal, ratio;
+  arma::mat B;
+  if (pattern != NULL) {
+    arma::sp_mat sigmaHat;
+    huberCovPatternInfo(X, n, p, p, *pattern, mu, sigmaHat, prof, mon, true, plan);
+    sigma = arma::vec(sigmaHat.diag());
+    B = factorLoadings(sigmaHat, n, p, K, plan, prof, eigenVal, ratio);
+  } else {
+    arma::mat sigmaHat;
+    bool hot = warm != NULL && (int)warm->sigmaHat.n_rows == p;
+    huberCovInfo(X, n, p, p, mu, sigmaHat, prof, mon, true, plan, hot ? &warm->sigmaHat : NULL);
+    sigma = sigmaHat.diag();
+    B = factorLoadings(sigmaHat, n, p, K, plan, prof, eigenVal, ratio, warm != NULL ? &warm->eigenVec : NULL);
+    if (warm != NULL) {
+      warm->sigmaHat.swap(sigmaHat);
+    }
+  }
+  farmTestAdjust(dataMeans(X), n, h0, mu, sigma, B, alpha, alternative, solver, prof, rst);
+  rst.eigenVal = eigenVal;
+  rst.ratio = ratio;
+  rst.hasEigen = true;
+}
+
+// [[Rcpp::export]]
+Rcpp::List farmTest(SEXP X, const arma::vec& h0, int K = -1, const double alpha = 0.05, const std::string alternative = "two.sided", 
+                    const bool profile = false, Rcpp::Nullable<Rcpp::Function> progress = R_NilValue, const int solver = 0, 
+                    Rcpp::Nullable<Rcpp::List> plan = R_NilValue, Rcpp::Nullable<Rcpp::IntegerMatrix> pattern = R_NilValue) {
+  FarmProfile prof(profile);
+  FarmMonitor mon(progress);
+  FarmResult rst;
+  FarmPlan execPlan(plan);
+  arma::umat pairs;
+  if (!pattern.isNull()) {
+    pairs = patternPairs(Rcpp::IntegerMatrix(pattern.get()));
+  }
+  const arma::umat* pat = pattern.isNull() ? NULL : &pairs;
+  if (Rf_isS4(X)) {
+    farmTestCore(Rcpp::as<arma::sp_mat>(X), h0, K, alpha, alternative, huberSolver(solver), prof, mon, rst, execPlan, NULL, pat);
+  } else if (TYPEOF(X) == INTSXP) {
+    Rcpp::IntegerMatrix x(X);
+    farmTestCore(arma::Mat<int>(x.begin(), x.nrow(), x.ncol(), false, true), h0, K, alpha, alternative, huberSolver(solver), prof, mon, rst, 
+                 execPlan, NULL, pat);
+  } else {
+    Rcpp::NumericMatrix x(X);
+    farmTestCore(arma::mat(x.begin(), x.nrow(), x.ncol(), false, true), h0, K, alpha, alternative, huberSolver(solver), prof, mon, rst, 
+                 execPlan, NULL, pat);
+  }
+  Rcpp::List rstList = rst.toList();
+  if (profile) {
+    rstList.push_back(prof.toList(), "profile");
+  }
+  return rstList;
+}
+
+// One-sample FarmTest refit on each window of width rows, every step rows, warm-started from the previous window.
+template <typename eT>
+Rcpp::List farmTestRollData(const arma::Mat<eT>& X, const arma::vec& h0, const int width, const int step, const int K, const double alpha, 
+                            const std::string& alternative, const HuberSolver solver, const bool profile, FarmMonitor& mon, 
+                            const FarmPlan& plan) {
+  int m = ((int)X.n_rows - width) / step + 1;
+  Rcpp::List rst(m);
+  FarmWarm warm;
+  for (int w = 0; w < m; w++) {
+    arma::Mat<eT> window = X.rows(w * step, w * step + width - 1);
+    FarmProfile prof(profile);
+    FarmResult res;
+    if (K == 0) {
+      rmTestCore(window, h0, alpha, alternative, prof, mon, res);
+    } else {
+      farmTestCore(window, h0, K, alpha, alternative, solver, prof, mon, res, plan, &warm);
+    }
+    Rcpp::List item = res.toList();
+    if (profile) {
+      item.push_back(prof.toList(), "profile");
+    }
+    rst[w] = item;
+  }
+  return rst;
+}
+
+// [[Rcpp::export]]
+Rcpp::List farmTestRoll(SEXP X, const arma::vec& h0, const int width, const int step = 1, const int K = -1, const double alpha = 0.05, 
+                        const std::string alternative = "two.sided", const bool profile = false, 
+                        Rcpp::Nullable<Rcpp::Function> progress = R_NilValue, const int solver = 0, 
+                        Rcpp::Nullable<Rcpp::List> plan = R_NilValue) {
+  FarmMonitor mon(progress);
+  FarmPlan execPlan(plan);
+  if (TYPEOF(X) == INTSXP) {
+    Rcpp::IntegerMatrix x(X);
+    return farmTestRollData(arma::Mat<int>(x.begin(), x.nrow(), x.ncol(), false, true), h0, width, step, K, alpha, alternative, 
+                            huberSolver(solver), profile, mon, execPlan);
+  }
+  Rcpp::NumericMatrix x(X);
+  return farmTestRollData(arma::mat(x.begin(), x.nrow(), x.ncol(), false, true), h0, width, step, K, alpha, alternative, 
+                          huberSolver(solver), profile, mon, execPlan);
+}
+
+// One-sample FarmTest for each K in Ks, sharing the covariance and the eigenpairs of the largest K.
+template <typename MatT>
+Rcpp::List farmTestSweepData(const MatT& X, const arma::vec& h0, const std::vector<int>& Ks, const double alpha, 
+                             const std::string& alternative, const HuberSolver solver, FarmProfile& prof, FarmMonitor& mon, 
+                             const FarmPlan& plan) {
+  int n = X.n_rows, p = X.n_cols, m = Ks.size();
+  for (int i = 0; i < m; i++) {
+    if (Ks[i] > p) {
+      Rcpp::stop("The numbers of factors must not exceed the number of columns of X");
+    }
+  }
+  arma::vec mu;
+  arma::mat sigmaHat;
+  huberCovInfo(X, n, p, p, mu, sigmaHat, prof, mon, true, plan);
   arma::vec sigma = sigmaHat.diag();
   arma::vec eigenVal;
   arma::mat eigenVec;
-  arma::eig_sym(eigenVal, eigenVec, sigmaHat);
-  arma::vec ratio;
-  if (K <= 0) {
-    ratio = getRatio(eigenVal, n, p);
-    K = arma::index_max(ratio) + 1;
+  int k = std::max(plan.nEigen, ratioLength(n, p) + 1);
+  for (int i = 0; i < m; i++) {
+    k = std::max(k, Ks[i]);
   }
-  arma::mat B(p, K);
-  for (int i = 1; i <= K; i++) {
-    double lambda = std::sqrt((long double)std::max(eigenVal(p - i), 0.0));
-    B.col(i - 1) = lambda * eigenVec.col(p - i);
-  }
-  arma::vec f = huberRegCoef(B, arma::mean(X, 0).t(), p, K);
-  for (int j = 0; j < p; j++) {
-    double temp = arma::norm(B.row(j), 2);
-    if (sigma(j) > temp * temp) {
-      sigma(j) -= temp * temp;
+  factorEigen(sigmaHat, k, plan, prof, eigenVal, eigenVec);
+  sigmaHat.reset();
+  arma::vec ratio = getRatio(eigenVal, n, p), xMean = dataMeans(X);
+  int kHat = arma::index_max(ratio) + 1;
+  Rcpp::List rst(m);
+  for (int i = 0; i < m; i++) {
+    int K = Ks[i] < 0 ? kHat : Ks[i];
+    if (K > (int)eigenVal.n_elem) {
+      Rcpp::stop("Fewer eigenpairs were computed than the number of factors");
     }
+    prof.setSample("K" + std::to_string(K));
+    FarmResult res;
+    farmTestAdjust(xMean, n, h0, mu, sigma, topLoadings(eigenVal, eigenVec, K), alpha, alternative, solver, prof, res);
+    res.eigenVal = eigenVal;
+    res.ratio = ratio;
+    res.hasEigen = K > 0;
+    rst[i] = res.toList();
   }
-  mu -= B * f;
-  sigma = arma::sqrt(sigma / n);
-  arma::vec T = (mu - h0) / sigma;
-  arma::vec Prob = getP(T, alternative);
-  arma::vec pAdjust = adjust(Prob, alpha, p);
-  arma::uvec significant = pAdjust <= alpha;
-  return Rcpp::List::create(Rcpp::Named("means") = mu, Rcpp::Named("stdDev") = sigma, Rcpp::Named("loadings") = B, Rcpp::Named("nfactors") = K, 
-                            Rcpp::Named("tStat") = T, Rcpp::Named("pValues") = Prob, Rcpp::Named("pAdjust") = pAdjust, 
-                            Rcpp::Named("significant") = significant, Rcpp::Named("eigens") = eigenVal, Rcpp::Named("ratio") = ratio);
+  prof.setSample("");
+  return rst;
+}
+
+// [[Rcpp::export]]
+Rcpp::List farmTestSweep(SEXP X, const arma::vec& h0, const std::vector<int>& Ks, const double alpha = 0.05, 
+                         const std::string alternative = "two.sided", const bool profile = false, 
+                         Rcpp::Nullable<Rcpp::Function> progress = R_NilValue, const int solver = 0, 
+                         Rcpp::Nullable<Rcpp::List> plan = R_NilValue) {
+  FarmProfile prof(profile);
+  FarmMonitor mon(progress);
+  FarmPlan execPlan(plan);
+  Rcpp::List rst;
+  if (Rf_isS4(X)) {
+    rst = farmTestSweepData(Rcpp::as<arma::sp_mat>(X), h0, Ks, alpha, alternative, huberSolver(solver), prof, mon, execPlan);
+  } else if (TYPEOF(X) == INTSXP) {
+    Rcpp::IntegerMatrix x(X);
+    rst = farmTestSweepData(arma::Mat<int>(x.begin(), x.nrow(), x.ncol(), false, true), h0, Ks, alpha, alternative, huberSolver(solver), 
+                            prof, mon, execPlan);
+  } else {
+    Rcpp::NumericMatrix x(X);
+    rst = farmTestSweepData(arma::mat(x.begin(), x.nrow(), x.ncol(), false, true), h0, Ks, alpha, alternative, huberSolver(solver), prof, 
+                            mon, execPlan);
+  }
+  Rcpp::List rstList = Rcpp::List::create(Rcpp::Named("results") = rst);
+  if (profile) {
+    rstList.push_back(prof.toList(), "profile");
+  }
+  return rstList;
 }
 
 // [[Rcpp::export]]
 Rcpp::List farmTestTwo(const arma::mat& X, const arma::mat& Y, const arma::vec& h0, int KX = -1, int KY = -1, const double alpha = 0.05, 
-                       const std::string alternative = "two.sided") {
+                       const std::string alternative = "two.sided", const bool profile = false, 
+                       Rcpp::Nullable<Rcpp::Function> progress = R_NilValue, const int solver = 0, 
+                       Rcpp::Nullable<Rcpp::List> plan = R_NilValue) {
+  const HuberSolver method = huberSolver(solver);
   int nX = X.n_rows, nY = Y.n_rows, p = X.n_cols;
-  Rcpp::List listCov = huberCov(X, nX, p);
-  arma::vec muX = listCov["means"];
-  arma::mat sigmaHat = listCov["cov"];
-  arma::vec sigmaX = sigmaHat.diag();
-  arma::vec eigenValX, eigenValY;
-  arma::mat eigenVec;
-  arma::eig_sym(eigenValX, eigenVec, sigmaHat);
-  arma::vec ratioX, ratioY;
-  if (KX <= 0) {
-    ratioX = getRatio(eigenValX, nX, p);
-    KX = arma::index_max(ratioX) + 1;
-  }
-  arma::mat BX(p, KX);
-  for (int i = 1; i <= KX; i++) {
-    double lambda = std::sqrt((long double)std::max(eigenValX(p - i), 0.0));
-    BX.col(i - 1) = lambda * eigenVec.col(p - i);
-  }
-  arma::vec fX = huberRegCoef(BX, arma::mean(X, 0).t(), p, KX);
-  listCov = huberCov(Y, nY, p);
-  arma::vec muY = listCov["means"];
-  sigmaHat = Rcpp::as<arma::mat>(listCov["cov"]);
-  arma::vec sigmaY = sigmaHat.diag();
-  arma::eig_sym(eigenValY, eigenVec, sigmaHat);
-  if (KY <= 0) {
-    ratioY = getRatio(eigenValY, nY, p);
-    KY = arma::index_max(ratioY) + 1;
-  }
-  arma::mat BY(p, KY);
-  for (int i = 1; i <= KY; i++) {
-    double lambda = std::sqrt((long double)std::max(eigenValY(p - i), 0.0));
-    BY.col(i - 1) = lambda * eigenVec.col(p - i);
-  }
-  arma::vec fY = huberRegCoef(BY, arma::mean(Y, 0).t(), p, KY);
+  FarmProfile prof(profile), profX(profile), profY(profile);
+  FarmMonitor mon(progress);
+  FarmPlan execPlan(plan);
+  profX.setSample("X");
+  profY.setSample("Y");
+  arma::vec muX, muY, sigmaX, sigmaY, meanX, meanY, fX, fY;
+  arma::mat sigmaHatX, sigmaHatY, BX, BY;
+  arma::vec eigenValX, eigenValY, ratioX, ratioY;
+  // The two samples are independent chains of covariance, loadings and factor regression, and the sample means that the
+  // regressions need are independent of the covariances
+  FarmGraph graph;
+  int covX = graph.add([&](FarmMonitor& m) {
+    huberCovInfo(X, nX, p, p, muX, sigmaHatX, profX, m, true, execPlan);
+    sigmaX = sigmaHatX.diag();
+  });
+  int covY = graph.add([&](FarmMonitor& m) {
+    huberCovInfo(Y, nY, p, p, muY, sigmaHatY, profY, m, true, execPlan);
+    sigmaY = sigmaHatY.diag();
+  });
+  int centerX = graph.add([&](FarmMonitor& m) {
+    meanX = arma::mean(X, 0).t();
+  });
+  int centerY = graph.add([&](FarmMonitor& m) {
+    meanY = arma::mean(Y, 0).t();
+  });
+  int loadX = graph.add([&](FarmMonitor& m) {
+    BX = factorLoadings(sigmaHatX, nX, p, KX, execPlan, profX, eigenValX, ratioX);
+    sigmaHatX.reset();
+  }, std::vector<int>(1, covX));
+  int loadY = graph.add([&](FarmMonitor& m) {
+    BY = factorLoadings(sigmaHatY, nY, p, KY, execPlan, profY, eigenValY, ratioY);
+    sigmaHatY.reset();
+  }, std::vector<int>(1, covY));
+  graph.add([&](FarmMonitor& m) {
+    SolveInfo info;
+    fX = huberRegCoefInfo(BX, meanX, p, KX, &info, 0.0001, 1.345, 5000, method);
+    profX.record(profX.addSlot("factorRegression", 1), 0, info);
+    profX.stage("factorRegression");
+  }, {loadX, centerX});
+  graph.add([&](FarmMonitor& m) {
+    SolveInfo info;
+    fY = huberRegCoefInfo(BY, meanY, p, KY, &info, 0.0001, 1.345, 5000, method);
+    profY.record(profY.addSlot("factorRegression", 1), 0, info);
+    profY.stage("factorRegression");
+  }, {loadY, centerY});
+  graph.run(mon, 2, execPlan.threads);
+  prof.merge(profX);
+  prof.merge(profY);
   for (int j = 0; j < p; j++) {
     double temp = arma::norm(BX.row(j), 2);
     if (sigmaX(j) > temp * temp) {
@@ -611,28 +2961,125 @@ Rcpp::List farmTestTwo(const arma::mat& X, const arma::mat& Y, const arma::vec&
   arma::vec Prob = getP(T, alternative);
   arma::vec pAdjust = adjust(Prob, alpha, p);
   arma::uvec significant = pAdjust <= alpha;
-  return Rcpp::List::create(Rcpp::Named("meansX") = muX, Rcpp::Named("meansY") = muY, Rcpp::Named("stdDevX") = sigmaX, 
-                            Rcpp::Named("stdDevY") = sigmaY, Rcpp::Named("loadingsX") = BX, Rcpp::Named("loadingsY") = BY,
-                            Rcpp::Named("nfactorsX") = KX, Rcpp::Named("nfactorsY") = KY, Rcpp::Named("tStat") = T, 
-                            Rcpp::Named("pValues") = Prob, Rcpp::Named("pAdjust") = pAdjust, Rcpp::Named("significant") = significant, 
-                            Rcpp::Named("eigensX") = eigenValX, Rcpp::Named("eigensY") = eigenValY, Rcpp::Named("ratioX") = ratioX, 
-                            Rcpp::Named("ratioY") = ratioY);
+  prof.stage("testing");
+  Rcpp::List rst = Rcpp::List::create(Rcpp::Named("meansX") = muX, Rcpp::Named("meansY") = muY, Rcpp::Named("stdDevX") = sigmaX, 
+                                      Rcpp::Named("stdDevY") = sigmaY, Rcpp::Named("loadingsX") = BX, Rcpp::Named("loadingsY") = BY,
+                                      Rcpp::Named("nfactorsX") = KX, Rcpp::Named("nfactorsY") = KY, Rcpp::Named("tStat") = T, 
+                                      Rcpp::Named("pValues") = Prob, Rcpp::Named("pAdjust") = pAdjust, Rcpp::Named("significant") = significant, 
+                                      Rcpp::Named("eigensX") = eigenValX, Rcpp::Named("eigensY") = eigenValY, Rcpp::Named("ratioX") = ratioX, 
+                                      Rcpp::Named("ratioY") = ratioY);
+  if (profile) {
+    rst.push_back(prof.toList(), "profile");
+  }
+  return rst;
+}
+
+// Robust means, standard errors and factor adjustment of one group of farmTestGroups, as in one-sample FarmTest with normal
+// approximation. With K = 0 no factor is adjusted.
+template <typename MatT>
+void farmGroupCore(const MatT& X, int K, const double alpha, const std::string& alternative, const HuberSolver solver, FarmProfile& prof, 
+                   FarmMonitor& mon, FarmResult& rst, const FarmPlan& plan) {
+  arma::vec h0 = arma::zeros(X.n_cols);
+  if (K == 0) {
+    rmTestCore(X, h0, alpha, alternative, prof, mon, rst);
+  } else {
+    farmTestCore(X, h0, K, alpha, alternative, solver, prof, mon, rst, plan);
+  }
 }
 
+// Contrasts between G groups: row i of contrasts weighs the factor-adjusted means of the groups, tested against h0.
 // [[Rcpp::export]]
-Rcpp::List farmTestFac(const arma::mat& X, const arma::mat& fac, const arma::vec& h0, const double alpha = 0.05, 
-                       const std::string alternative = "two.sided") {
+Rcpp::List farmTestGroups(const Rcpp::List& XList, const arma::vec& h0, const Rcpp::IntegerVector& KList, const arma::mat& contrasts, 
+                          const double alpha = 0.05, const std::string alternative = "two.sided", const bool profile = false, 
+                          Rcpp::Nullable<Rcpp::Function> progress = R_NilValue, const int solver = 0, 
+                          Rcpp::Nullable<Rcpp::List> plan = R_NilValue) {
+  const HuberSolver method = huberSolver(solver);
+  int G = XList.size(), m = contrasts.n_rows, p = h0.n_elem;
+  FarmProfile prof(profile);
+  FarmMonitor mon(progress);
+  FarmPlan execPlan(plan);
+  // The groups are independent chains of stages, run side by side on the thread pool. Their data are unwrapped here, since
+  // the stages must not call into R.
+  std::vector<arma::sp_mat> sparse(G);
+  std::vector<int*> xInt(G, NULL);
+  std::vector<double*> xDouble(G, NULL);
+  std::vector<int> n(G);
+  std::vector<FarmProfile> profs(G, FarmProfile(profile));
+  std::vector<FarmResult> results(G);
+  FarmGraph graph;
+  for (int g = 0; g < G; g++) {
+    SEXP X = XList[g];
+    if (Rf_isS4(X)) {
+      sparse[g] = Rcpp::as<arma::sp_mat>(X);
+      n[g] = sparse[g].n_rows;
+    } else if (TYPEOF(X) == INTSXP) {
+      Rcpp::IntegerMatrix x(X);
+      xInt[g] = x.begin();
+      n[g] = x.nrow();
+    } else {
+      Rcpp::NumericMatrix x(X);
+      xDouble[g] = x.begin();
+      n[g] = x.nrow();
+    }
+    profs[g].setSample("group" + std::to_string(g + 1));
+    int K = KList[g];
+    graph.add([&, g, K](FarmMonitor& m) {
+      if (xInt[g] != NULL) {
+        farmGroupCore(arma::Mat<int>(xInt[g], n[g], p, false, true), K, alpha, alternative, method, profs[g], m, results[g], execPlan);
+      } else if (xDouble[g] != NULL) {
+        farmGroupCore(arma::mat(xDouble[g], n[g], p, false, true), K, alpha, alternative, method, profs[g], m, results[g], execPlan);
+      } else {
+        farmGroupCore(sparse[g], K, alpha, alternative, method, profs[g], m, results[g], execPlan);
+      }
+    });
+  }
+  graph.run(mon, G, execPlan.threads);
+  arma::mat mu(p, G), sigma(p, G);
+  Rcpp::List groups(G);
+  for (int g = 0; g < G; g++) {
+    prof.merge(profs[g]);
+    mu.col(g) = results[g].mu;
+    sigma.col(g) = results[g].sigma;
+    groups[g] = results[g].toList();
+  }
+  arma::mat var = arma::square(sigma);
+  Rcpp::List rst(m);
+  for (int i = 0; i < m; i++) {
+    arma::vec c = contrasts.row(i).t();
+    FarmResult contrast;
+    contrast.mu = mu * c;
+    contrast.sigma = arma::sqrt(var * arma::square(c));
+    contrast.test(h0, alpha, alternative);
+    rst[i] = contrast.toList();
+  }
+  prof.stage("contrasts");
+  Rcpp::List rstList = Rcpp::List::create(Rcpp::Named("groups") = groups, Rcpp::Named("contrasts") = rst);
+  if (profile) {
+    rstList.push_back(prof.toList(), "profile");
+  }
+  return rstList;
+}
+
+template <typename MatT>
+void farmTestFacCore(const MatT& X, const arma::mat& fac, const arma::vec& h0, const double alpha, const std::string& alternative, 
+                     const HuberSolver solver, FarmProfile& prof, FarmMonitor& mon, FarmResult& rst) {
   int n = X.n_rows, p = X.n_cols, K = fac.n_cols;
+  int slotReg = prof.addSlot("regression", p), slotSecond = prof.addSlot("secondMoments", p);
+  SolveInfo info;
   arma::mat Sigma = arma::cov(fac);
   arma::vec mu(p), sigma(p);
   arma::vec theta, beta;
   arma::mat B(p, K);
-  for (int j = 0; j < p; j++) {
-    theta = huberReg(fac, X.col(j), n, K);
+  mon.begin("regression", p);
+  for (int j = 0; j < p && !mon.tick(); j++) {
+    const arma::vec x = dataColVec(X, j);
+    theta = huberRegInfo(fac, x, n, K, &info, 0.0001, 1.345, 5000, solver);
+    prof.record(slotReg, j, info);
     mu(j) = theta(0);
     beta = theta.rows(1, K);
     B.row(j) = beta.t();
-    double sig = huberMean(arma::square(X.col(j)), n);
+    double sig = huberSecondCol(X, j, x, &info);
+    prof.record(slotSecond, j, info);
     double temp = mu(j) * mu(j);
     if (sig > temp) {
       sig -= temp;
@@ -643,55 +3090,138 @@ Rcpp::List farmTestFac(const arma::mat& X, const arma::mat& fac, const arma::vec
     }
     sigma(j) = sig;
   }
-  sigma = arma::sqrt(sigma / n);
-  arma::vec T = (mu - h0) / sigma;
-  arma::vec Prob = getP(T, alternative);
-  arma::vec pAdjust = adjust(Prob, alpha, p);
-  arma::uvec significant = pAdjust <= alpha;
-  return Rcpp::List::create(Rcpp::Named("means") = mu, Rcpp::Named("stdDev") = sigma, Rcpp::Named("loadings") = B, Rcpp::Named("nfactors") = K,
-                            Rcpp::Named("tStat") = T, Rcpp::Named("pValues") = Prob, Rcpp::Named("pAdjust") = pAdjust, 
-                            Rcpp::Named("significant") = significant);
+  mon.abort();
+  prof.stage("regression");
+  rst.mu = mu;
+  rst.sigma = arma::sqrt(sigma / n);
+  rst.B = B;
+  rst.K = K;
+  rst.test(h0, alpha, alternative);
+  prof.stage("testing");
 }
 
 // [[Rcpp::export]]
-Rcpp::List farmTestFacBoot(const arma::mat& X, const arma::mat& fac, const arma::vec& h0, const double alpha = 0.05, 
-                           const std::string alternative = "two.sided", const int B = 500) {
+Rcpp::List farmTestFac(SEXP X, const arma::mat& fac, const arma::vec& h0, const double alpha = 0.05, 
+                       const std::string alternative = "two.sided", const bool profile = false, 
+                       Rcpp::Nullable<Rcpp::Function> progress = R_NilValue, const int solver = 0) {
+  FarmProfile prof(profile);
+  FarmMonitor mon(progress);
+  FarmResult rst;
+  if (Rf_isS4(X)) {
+    farmTestFacCore(Rcpp::as<arma::sp_mat>(X), fac, h0, alpha, alternative, huberSolver(solver), prof, mon, rst);
+  } else if (TYPEOF(X) == INTSXP) {
+    Rcpp::IntegerMatrix x(X);
+    farmTestFacCore(arma::Mat<int>(x.begin(), x.nrow(), x.ncol(), false, true), fac, h0, alpha, alternative, huberSolver(solver), prof, mon, 
+                    rst);
+  } else {
+    Rcpp::NumericMatrix x(X);
+    farmTestFacCore(arma::mat(x.begin(), x.nrow(), x.ncol(), false, true), fac, h0, alpha, alternative, huberSolver(solver), prof, mon, rst);
+  }
+  Rcpp::List rstList = rst.toList();
+  if (profile) {
+    rstList.push_back(prof.toList(), "profile");
+  }
+  return rstList;
+}
+
+template <typename eT>
+Rcpp::List farmTestFacBootData(const arma::Mat<eT>& X, const arma::mat& fac, const arma::vec& h0, const double alpha, 
+                               const std::string& alternative, const int B, const bool profile, Rcpp::Nullable<Rcpp::Function> progress, 
+                               const bool partial, const HuberSolver solver, const bool keepBoot) {
   int n = X.n_rows, p = X.n_cols, K = fac.n_cols;
+  FarmProfile prof(profile);
+  FarmMonitor mon(progress);
+  int slotMean = prof.addSlot("means", p);
+  SolveInfo info;
   arma::vec mu(p);
-  for (int j = 0; j < p; j++) {
-    mu(j) = huberRegItcp(fac, X.col(j), n, K);
+  mon.begin("estimate", p);
+  for (int j = 0; j < p && !mon.tick(); j++) {
+    mu(j) = huberRegItcpInfo(fac, dataColVec(X, j), n, K, &info, 0.0001, 1.345, 5000, solver);
+    prof.record(slotMean, j, info);
   }
-  arma::mat boot(p, B);
-  for (int i = 0; i < B; i++) {
+  mon.abort();
+  prof.stage("estimate");
+  int slotBoot = prof.addSlot("bootstrap", p);
+  BootCounter boot(mu, h0, alternative, p, B, keepBoot);
+  arma::vec rep(p);
+  mon.begin("bootstrap", (long long)B * p);
+  while (boot.size() < B && !mon.cancelled()) {
     arma::uvec idx = arma::find(arma::randi(n, arma::distr_param(0, 1)) == 1);
     int subn = idx.size();
-    arma::mat subX = X.rows(idx);
-    for (int j = 0; j < p; j++) {
-      boot(j, i) = huberRegItcp(fac.rows(idx), subX.col(j), subn, K);
+    arma::Mat<eT> subX = X.rows(idx);
+    for (int j = 0; j < p && !mon.tick(); j++) {
+      rep(j) = huberRegItcpInfo(fac.rows(idx), dataColVec(subX, j), subn, K, &info, 0.0001, 1.345, 5000, solver);
+      prof.record(slotBoot, j, info);
+    }
+    if (mon.cancelled()) {
+      break;
     }
+    boot.add(rep);
   }
-  arma::vec Prob = getPboot(mu, boot, h0, alternative, p, B);
+  if (!partial || boot.size() == 0) {
+    mon.abort();
+  }
+  prof.stage("bootstrap");
+  arma::vec Prob = boot.pValues();
   arma::vec pAdjust = adjust(Prob, alpha, p);
   arma::uvec significant = pAdjust <= alpha;
-  return Rcpp::List::create(Rcpp::Named("means") = mu, Rcpp::Named("nfactors") = K, Rcpp::Named("pValues") = Prob, 
-                            Rcpp::Named("pAdjust") = pAdjust, Rcpp::Named("significant") = significant);
+  prof.stage("testing");
+  Rcpp::List rst = Rcpp::List::create(Rcpp::Named("means") = mu, Rcpp::Named("nfactors") = K, Rcpp::Named("pValues") = Prob, 
+                                      Rcpp::Named("pAdjust") = pAdjust, Rcpp::Named("significant") = significant);
+  if (mon.cancelled()) {
+    rst.push_back(true, "interrupted");
+    rst.push_back(boot.size(), "nBoot");
+  }
+  if (keepBoot) {
+    rst.push_back(boot.replicates(), "bootstrap");
+  }
+  if (profile) {
+    rst.push_back(prof.toList(), "profile");
+  }
+  return rst;
+}
+
+// [[Rcpp::export]]
+Rcpp::List farmTestFacBoot(SEXP X, const arma::mat& fac, const arma::vec& h0, const double alpha = 0.05, 
+                           const std::string alternative = "two.sided", const int B = 500, const bool profile = false, 
+                           Rcpp::Nullable<Rcpp::Function> progress = R_NilValue, const bool partial = false, 
+                           const int solver = 0, const bool keepBoot = false) {
+  if (TYPEOF(X) == INTSXP) {
+    Rcpp::IntegerMatrix x(X);
+    return farmTestFacBootData(arma::Mat<int>(x.begin(), x.nrow(), x.ncol(), false, true), fac, h0, alpha, alternative, B, profile, 
+                               progress, partial, huberSolver(solver), keepBoot);
+  }
+  Rcpp::NumericMatrix x(X);
+  return farmTestFacBootData(arma::mat(x.begin(), x.nrow(), x.ncol(), false, true), fac, h0, alpha, alternative, B, profile, progress, 
+                             partial, huberSolver(solver), keepBoot);
 }
 
 // [[Rcpp::export]]
 Rcpp::List farmTestTwoFac(const arma::mat& X, const arma::mat& facX, const arma::mat& Y, const arma::mat& facY, const arma::vec& h0, 
-                          const double alpha = 0.05, const std::string alternative = "two.sided") {
+                          const double alpha = 0.05, const std::string alternative = "two.sided", const bool profile = false, 
+                          Rcpp::Nullable<Rcpp::Function> progress = R_NilValue, const int solver = 0) {
+  const HuberSolver method = huberSolver(solver);
   int nX = X.n_rows, nY = Y.n_rows, p = X.n_cols, KX = facX.n_cols, KY = facY.n_cols;
+  FarmProfile prof(profile);
+  FarmMonitor mon(progress);
+  int slotRegX = prof.addSlot("X.regression", p), slotRegY = prof.addSlot("Y.regression", p);
+  int slotSecondX = prof.addSlot("X.secondMoments", p), slotSecondY = prof.addSlot("Y.secondMoments", p);
+  SolveInfo info;
   arma::mat SigmaX = arma::cov(facX);
   arma::mat SigmaY = arma::cov(facY);
   arma::vec muX(p), sigmaX(p), muY(p), sigmaY(p);
   arma::vec theta, beta;
   arma::mat BX(p, KX), BY(p, KY);
-  for (int j = 0; j < p; j++) {
-    theta = huberReg(facX, X.col(j), nX, KX);
+  mon.begin("regression", p);
+  for (int j = 0; j < p && !mon.tick(); j++) {
+    theta = huberRegInfo(facX, dataColVec(X, j), nX, KX, &info, 0.0001, 1.345, 5000, method);
+    prof.record(slotRegX, j, info);
     muX(j) = theta(0);
     beta = theta.rows(1, KX);
     BX.row(j) = beta.t();
-    double sig = huberMean(arma::square(X.col(j)), nX);
+    double sig, dummy;
+    huberMeanSecondInfo(X.colptr(j), nX, dummy, sig, NULL, &info);
+    prof.record(slotSecondX, j, info);
     double temp = muX(j) * muX(j);
     if (sig > temp) {
       sig -= temp;
@@ -701,11 +3231,13 @@ Rcpp::List farmTestTwoFac(const arma::mat& X, const arma::mat& facX, const arma:
       sig -= temp;
     }
     sigmaX(j) = sig;
-    theta = huberReg(facY, Y.col(j), nY, KY);
+    theta = huberRegInfo(facY, dataColVec(Y, j), nY, KY, &info, 0.0001, 1.345, 5000, method);
+    prof.record(slotRegY, j, info);
     muY(j) = theta(0);
     beta = theta.rows(1, KY);
     BY.row(j) = beta.t();
-    sig = huberMean(arma::square(Y.col(j)), nY);
+    huberMeanSecondInfo(Y.colptr(j), nY, dummy, sig, NULL, &info);
+    prof.record(slotSecondY, j, info);
     temp = muY(j) * muY(j);
     if (sig > temp) {
       sig -= temp;
@@ -716,46 +3248,321 @@ Rcpp::List farmTestTwoFac(const arma::mat& X, const arma::mat& facX, const arma:
     }
     sigmaY(j) = sig;
   }
+  mon.abort();
+  prof.stage("regression");
   arma::vec T = (muX - muY - h0) / arma::sqrt(sigmaX / nX + sigmaY / nY);
   sigmaX = arma::sqrt(sigmaX / nX);
   sigmaY = arma::sqrt(sigmaY / nY);
   arma::vec Prob = getP(T, alternative);
   arma::vec pAdjust = adjust(Prob, alpha, p);
   arma::uvec significant = pAdjust <= alpha;
-  return Rcpp::List::create(Rcpp::Named("meansX") = muX, Rcpp::Named("meansY") = muY, Rcpp::Named("stdDevX") = sigmaX, 
-                            Rcpp::Named("stdDevY") = sigmaY, Rcpp::Named("loadingsX") = BX, Rcpp::Named("loadingsY") = BY,
-                            Rcpp::Named("nfactorsX") = KX, Rcpp::Named("nfactorsY") = KY, Rcpp::Named("tStat") = T, 
-                            Rcpp::Named("pValues") = Prob, Rcpp::Named("pAdjust") = pAdjust, Rcpp::Named("significant") = significant);
+  prof.stage("testing");
+  Rcpp::List rst = Rcpp::List::create(Rcpp::Named("meansX") = muX, Rcpp::Named("meansY") = muY, Rcpp::Named("stdDevX") = sigmaX, 
+                                      Rcpp::Named("stdDevY") = sigmaY, Rcpp::Named("loadingsX") = BX, Rcpp::Named("loadingsY") = BY,
+                                      Rcpp::Named("nfactorsX") = KX, Rcpp::Named("nfactorsY") = KY, Rcpp::Named("tStat") = T, 
+                                      Rcpp::Named("pValues") = Prob, Rcpp::Named("pAdjust") = pAdjust, Rcpp::Named("significant") = significant);
+  if (profile) {
+    rst.push_back(prof.toList(), "profile");
+  }
+  return rst;
 }
 
 // [[Rcpp::export]]
 Rcpp::List farmTestTwoFacBoot(const arma::mat& X, const arma::mat& facX, const arma::mat& Y, const arma::mat& facY, 
-                              const arma::vec& h0, const double alpha = 0.05, const std::string alternative = "two.sided", const int B = 500) {
+                              const arma::vec& h0, const double alpha = 0.05, const std::string alternative = "two.sided", const int B = 500, 
+                              const bool profile = false, Rcpp::Nullable<Rcpp::Function> progress = R_NilValue, 
+                              const bool partial = false, const int solver = 0, const bool keepBoot = false) {
+  const HuberSolver method = huberSolver(solver);
   int nX = X.n_rows, nY = Y.n_rows, p = X.n_cols, KX = facX.n_cols, KY = facY.n_cols;
+  FarmProfile prof(profile);
+  FarmMonitor mon(progress);
+  int slotMeanX = prof.addSlot("X.means", p), slotMeanY = prof.addSlot("Y.means", p);
+  SolveInfo info;
   arma::vec muX(p), muY(p);
-  for (int j = 0; j < p; j++) {
-    muX(j) = huberRegItcp(facX, X.col(j), nX, KX);
-    muY(j) = huberRegItcp(facY, Y.col(j), nY, KY);
+  mon.begin("estimate", p);
+  for (int j = 0; j < p && !mon.tick(); j++) {
+    muX(j) = huberRegItcpInfo(facX, dataColVec(X, j), nX, KX, &info, 0.0001, 1.345, 5000, method);
+    prof.record(slotMeanX, j, info);
+    muY(j) = huberRegItcpInfo(facY, dataColVec(Y, j), nY, KY, &info, 0.0001, 1.345, 5000, method);
+    prof.record(slotMeanY, j, info);
   }
-  arma::mat bootX(p, B), bootY(p, B);
-  for (int i = 0; i < B; i++) {
+  mon.abort();
+  prof.stage("estimate");
+  int slotBootX = prof.addSlot("X.bootstrap", p), slotBootY = prof.addSlot("Y.bootstrap", p);
+  BootCounter boot(muX - muY, h0, alternative, p, B, keepBoot);
+  arma::vec rep(p);
+  mon.begin("bootstrap", (long long)B * p * 2);
+  while (boot.size() < B && !mon.cancelled()) {
     arma::uvec idx = arma::find(arma::randi(nX, arma::distr_param(0, 1)) == 1);
     int subn = idx.size();
     arma::mat subX = X.rows(idx);
-    for (int j = 0; j < p; j++) {
-      bootX(j, i) = huberRegItcp(facX.rows(idx), subX.col(j), subn, KX);
+    for (int j = 0; j < p && !mon.tick(); j++) {
+      rep(j) = huberRegItcpInfo(facX.rows(idx), dataColVec(subX, j), subn, KX, &info, 0.0001, 1.345, 5000, method);
+      prof.record(slotBootX, j, info);
     }
     idx = arma::find(arma::randi(nY, arma::distr_param(0, 1)) == 1);
     subn = idx.size();
     arma::mat subY = Y.rows(idx);
-    for (int j = 0; j < p; j++) {
-      bootY(j, i) = huberRegItcp(facY.rows(idx), subY.col(j), subn, KY);
+    for (int j = 0; j < p && !mon.tick(); j++) {
+      rep(j) -= huberRegItcpInfo(facY.rows(idx), dataColVec(subY, j), subn, KY, &info, 0.0001, 1.345, 5000, method);
+      prof.record(slotBootY, j, info);
+    }
+    if (mon.cancelled()) {
+      break;
     }
+    boot.add(rep);
   }
-  arma::vec Prob = getPboot(muX - muY, bootX - bootY, h0, alternative, p, B);
+  if (!partial || boot.size() == 0) {
+    mon.abort();
+  }
+  prof.stage("bootstrap");
+  arma::vec Prob = boot.pValues();
   arma::vec pAdjust = adjust(Prob, alpha, p);
   arma::uvec significant = pAdjust <= alpha;
-  return Rcpp::List::create(Rcpp::Named("meansX") = muX, Rcpp::Named("meansY") = muY, Rcpp::Named("nfactorsX") = KX, 
-                            Rcpp::Named("nfactorsY") = KY, Rcpp::Named("pValues") = Prob, Rcpp::Named("pAdjust") = pAdjust, 
-                            Rcpp::Named("significant") = significant);
+  prof.stage("testing");
+  Rcpp::List rst = Rcpp::List::create(Rcpp::Named("meansX") = muX, Rcpp::Named("meansY") = muY, Rcpp::Named("nfactorsX") = KX, 
+                                      Rcpp::Named("nfactorsY") = KY, Rcpp::Named("pValues") = Prob, Rcpp::Named("pAdjust") = pAdjust, 
+                                      Rcpp::Named("significant") = significant);
+  if (mon.cancelled()) {
+    rst.push_back(true, "interrupted");
+    rst.push_back(boot.size(), "nBoot");
+  }
+  if (keepBoot) {
+    rst.push_back(boot.replicates(), "bootstrap");
+  }
+  if (profile) {
+    rst.push_back(prof.toList(), "profile");
+  }
+  return rst;
+}
+
+// One-sample tests with normal approximation on a list of datasets, run largest first on one OpenMP pool. If pooled,
+// the p-values are adjusted over all datasets together.
+// [[Rcpp::export]]
+Rcpp::List farmTestBatch(const Rcpp::List& XList, const Rcpp::List& facList, const Rcpp::List& h0List, const Rcpp::IntegerVector& KList, 
+                         const double alpha = 0.05, const std::string alternative = "two.sided", const bool pooled = false, 
+                         const int nThreads = 1, Rcpp::Nullable<Rcpp::Function> progress = R_NilValue, const int solver = 0) {
+  const HuberSolver method = huberSolver(solver);
+  int m = XList.size();
+  std::vector<double*> X(m), fac(m, NULL), h0(m);
+  std::vector<int> n(m), p(m), K(KList.begin(), KList.end());
+  std::vector<double> cost(m);
+  for (int i = 0; i < m; i++) {
+    Rcpp::NumericMatrix x = XList[i];
+    X[i] = x.begin();
+    n[i] = x.nrow();
+    p[i] = x.ncol();
+    h0[i] = Rcpp::NumericVector(h0List[i]).begin();
+    if (!Rcpp::RObject(facList[i]).isNULL()) {
+      Rcpp::NumericMatrix f = facList[i];
+      fac[i] = f.begin();
+      K[i] = f.ncol();
+    }
+    cost[i] = fac[i] != NULL || K[i] == 0 ? (double)n[i] * p[i] : (double)n[i] * n[i] * p[i] * p[i];
+  }
+  std::vector<int> order(m);
+  for (int i = 0; i < m; i++) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), [&cost](const int a, const int b) { return cost[a] > cost[b]; });
+  std::vector<FarmResult> rst(m);
+  std::vector<std::string> error(m);
+  int threads = nThreads;
+# ifdef _OPENMP
+  if (threads <= 0) {
+    threads = omp_get_max_threads();
+  }
+# endif
+  FarmMonitor mon(progress);
+  mon.begin("batch", m);
+  #pragma omp parallel for schedule(dynamic, 1) num_threads(threads)
+  for (int k = 0; k < m; k++) {
+    int i = order[k];
+    if (mon.cancelled()) {
+      continue;
+    }
+    FarmProfile prof(false);
+    FarmMonitor child(&mon);
+    try {
+      const arma::mat x(X[i], n[i], p[i], false, true);
+      const arma::vec h(h0[i], p[i], false, true);
+      if (fac[i] != NULL) {
+        const arma::mat f(fac[i], n[i], K[i], false, true);
+        farmTestFacCore(x, f, h, alpha, alternative, method, prof, child, rst[i]);
+      } else if (K[i] == 0) {
+        rmTestCore(x, h, alpha, alternative, prof, child, rst[i]);
+      } else {
+        farmTestCore(x, h, K[i], alpha, alternative, method, prof, child, rst[i]);
+      }
+    } catch (std::exception& e) {
+      error[i] = e.what();
+    }
+    mon.tick();
+  }
+  mon.abort();
+  for (int i = 0; i < m; i++) {
+    if (!error[i].empty()) {
+      Rcpp::stop("dataset " + std::to_string(i + 1) + ": " + error[i]);
+    }
+  }
+  if (pooled) {
+    arma::uword total = 0;
+    for (int i = 0; i < m; i++) {
+      total += rst[i].Prob.n_elem;
+    }
+    arma::vec Prob(total);
+    for (int i = 0, start = 0; i < m; start += rst[i].Prob.n_elem, i++) {
+      Prob.subvec(start, arma::size(rst[i].Prob)) = rst[i].Prob;
+    }
+    arma::vec pAdjust = adjust(Prob, alpha, total);
+    for (int i = 0, start = 0; i < m; start += rst[i].Prob.n_elem, i++) {
+      rst[i].pAdjust = pAdjust.subvec(start, arma::size(rst[i].Prob));
+      rst[i].significant = rst[i].pAdjust <= alpha;
+    }
+  }
+  Rcpp::List rstList(m);
+  for (int i = 0; i < m; i++) {
+    rstList[i] = rst[i].toList();
+  }
+  return rstList;
+}
+
+// One-sample test with normal approximation on a native background thread, which never calls into R.
+class FarmJob {
+private:
+  arma::mat X, fac;
+  arma::sp_mat XSparse;
+  bool sparse;
+  arma::vec h0;
+  int K;
+  double alpha;
+  std::string alternative;
+  HuberSolver solver;
+  std::string error;
+  std::atomic<bool> finished;
+  bool aborted;
+  std::mutex doneLock;
+  std::condition_variable doneCond;
+  std::thread worker;
+
+  template <typename MatT>
+  void runData(const MatT& data) {
+    FarmProfile prof(false);
+    if (fac.n_cols > 0) {
+      farmTestFacCore(data, fac, h0, alpha, alternative, solver, prof, mon, rst);
+    } else if (K == 0) {
+      rmTestCore(data, h0, alpha, alternative, prof, mon, rst);
+    } else {
+      farmTestCore(data, h0, K, alpha, alternative, solver, prof, mon, rst);
+    }
+  }
+
+  void run() {
+    try {
+      if (sparse) {
+        runData(XSparse);
+      } else {
+        runData(X);
+      }
+    } catch (std::exception& e) {
+      error = e.what();
+    } catch (...) {
+      // abort() of the detached monitor after cancel()
+      aborted = true;
+    }
+    std::lock_guard<std::mutex> lock(doneLock);
+    finished = true;
+    doneCond.notify_all();
+  }
+
+public:
+  FarmMonitor mon;
+  FarmResult rst;
+
+  FarmJob(SEXP x, const arma::mat& f, const arma::vec& h, const int k, const double a, const std::string& alt, const HuberSolver sv)
+    : fac(f), sparse(Rf_isS4(x)), h0(h), K(k), alpha(a), alternative(alt), solver(sv), finished(false), aborted(false) {
+    if (sparse) {
+      XSparse = Rcpp::as<arma::sp_mat>(x);
+    } else {
+      X = Rcpp::as<arma::mat>(x);
+    }
+    mon.detach();
+    worker = std::thread(&FarmJob::run, this);
+  }
+
+  ~FarmJob() {
+    mon.cancel();
+    if (worker.joinable()) {
+      worker.join();
+    }
+  }
+
+  bool wait(const double seconds) {
+    std::unique_lock<std::mutex> lock(doneLock);
+    return doneCond.wait_for(lock, std::chrono::duration<double>(seconds), [this] { return (bool)finished; });
+  }
+
+  bool isFinished() const {
+    return finished;
+  }
+
+  bool isAborted() const {
+    return aborted;
+  }
+
+  const std::string& getError() const {
+    return error;
+  }
+};
+
+// The handle is passed to R as a plain SEXP, so that RcppExports.cpp does not need the declaration of FarmJob
+// [[Rcpp::export]]
+SEXP farmAsyncStart(SEXP X, const arma::mat& fac, const arma::vec& h0, const int K = -1, const double alpha = 0.05, 
+                    const std::string alternative = "two.sided", const int solver = 0) {
+  Rcpp::XPtr<FarmJob> job(new FarmJob(X, fac, h0, K, alpha, alternative, huberSolver(solver)), true);
+  return job;
+}
+
+// [[Rcpp::export]]
+Rcpp::List farmAsyncStatus(SEXP handle) {
+  Rcpp::XPtr<FarmJob> job(handle);
+  bool finished = job->isFinished();
+  return Rcpp::List::create(Rcpp::Named("finished") = finished, Rcpp::Named("cancelled") = job->mon.cancelled(), 
+                            Rcpp::Named("aborted") = finished && job->isAborted(), Rcpp::Named("stage") = job->mon.stage(), 
+                            Rcpp::Named("done") = (double)job->mon.progress(), Rcpp::Named("total") = (double)job->mon.size());
+}
+
+// Waits in slices of 0.1 seconds so that a user interrupt ends the wait, but not the job
+// [[Rcpp::export]]
+bool farmAsyncWait(SEXP handle, const double timeout = -1) {
+  Rcpp::XPtr<FarmJob> job(handle);
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  while (!job->wait(0.1)) {
+    Rcpp::checkUserInterrupt();
+    if (timeout >= 0 && std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() >= timeout) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// [[Rcpp::export]]
+void farmAsyncCancel(SEXP handle) {
+  Rcpp::XPtr<FarmJob> job(handle);
+  job->mon.cancel();
+}
+
+// [[Rcpp::export]]
+Rcpp::List farmAsyncResult(SEXP handle) {
+  Rcpp::XPtr<FarmJob> job(handle);
+  if (!job->isFinished()) {
+    Rcpp::stop("The computation has not finished yet");
+  }
+  if (job->isAborted()) {
+    Rcpp::stop("The computation was cancelled");
+  }
+  if (!job->getError().empty()) {
+    Rcpp::stop(job->getError());
+  }
+  return job->rst.toList();
 }
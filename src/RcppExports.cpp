@@ -126,12 +126,12 @@ BEGIN_RCPP
 END_RCPP
 }
 // huberMean
-double huberMean(arma::vec X, const int n, const double tol, const int iteMax);
+double huberMean(const arma::vec& X, const int n, const double tol, const int iteMax);
 RcppExport SEXP _FarmTest_huberMean(SEXP XSEXP, SEXP nSEXP, SEXP tolSEXP, SEXP iteMaxSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< arma::vec >::type X(XSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type X(XSEXP);
     Rcpp::traits::input_parameter< const int >::type n(nSEXP);
     Rcpp::traits::input_parameter< const double >::type tol(tolSEXP);
     Rcpp::traits::input_parameter< const int >::type iteMax(iteMaxSEXP);
@@ -139,6 +139,35 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// huberMeanSecond
+arma::vec huberMeanSecond(const arma::vec& X, const int n, const double tol, const int iteMax);
+RcppExport SEXP _FarmTest_huberMeanSecond(SEXP XSEXP, SEXP nSEXP, SEXP tolSEXP, SEXP iteMaxSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::vec& >::type X(XSEXP);
+    Rcpp::traits::input_parameter< const int >::type n(nSEXP);
+    Rcpp::traits::input_parameter< const double >::type tol(tolSEXP);
+    Rcpp::traits::input_parameter< const int >::type iteMax(iteMaxSEXP);
+    rcpp_result_gen = Rcpp::wrap(huberMeanSecond(X, n, tol, iteMax));
+    return rcpp_result_gen;
+END_RCPP
+}
+// huberMeanBinned
+Rcpp::NumericVector huberMeanBinned(const arma::vec& X, const int n, const int bins, const double tol, const int iteMax);
+RcppExport SEXP _FarmTest_huberMeanBinned(SEXP XSEXP, SEXP nSEXP, SEXP binsSEXP, SEXP tolSEXP, SEXP iteMaxSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::vec& >::type X(XSEXP);
+    Rcpp::traits::input_parameter< const int >::type n(nSEXP);
+    Rcpp::traits::input_parameter< const int >::type bins(binsSEXP);
+    Rcpp::traits::input_parameter< const double >::type tol(tolSEXP);
+    Rcpp::traits::input_parameter< const int >::type iteMax(iteMaxSEXP);
+    rcpp_result_gen = Rcpp::wrap(huberMeanBinned(X, n, bins, tol, iteMax));
+    return rcpp_result_gen;
+END_RCPP
+}
 // huberMeanVec
 arma::vec huberMeanVec(const arma::mat& X, const int n, const int p, const double epsilon, const int iteMax);
 RcppExport SEXP _FarmTest_huberMeanVec(SEXP XSEXP, SEXP nSEXP, SEXP pSEXP, SEXP epsilonSEXP, SEXP iteMaxSEXP) {
@@ -155,8 +184,8 @@ BEGIN_RCPP
 END_RCPP
 }
 // hMeanCov
-double hMeanCov(const arma::vec& Z, const int n, const int d, const int N, double rhs, const double epsilon, const int iteMax);
-RcppExport SEXP _FarmTest_hMeanCov(SEXP ZSEXP, SEXP nSEXP, SEXP dSEXP, SEXP NSEXP, SEXP rhsSEXP, SEXP epsilonSEXP, SEXP iteMaxSEXP) {
+Rcpp::NumericVector hMeanCov(const arma::vec& Z, const int n, const int d, const int N, double rhs, const double epsilon, const int iteMax, const bool accel);
+RcppExport SEXP _FarmTest_hMeanCov(SEXP ZSEXP, SEXP nSEXP, SEXP dSEXP, SEXP NSEXP, SEXP rhsSEXP, SEXP epsilonSEXP, SEXP iteMaxSEXP, SEXP accelSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -167,20 +196,60 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< double >::type rhs(rhsSEXP);
     Rcpp::traits::input_parameter< const double >::type epsilon(epsilonSEXP);
     Rcpp::traits::input_parameter< const int >::type iteMax(iteMaxSEXP);
-    rcpp_result_gen = Rcpp::wrap(hMeanCov(Z, n, d, N, rhs, epsilon, iteMax));
+    Rcpp::traits::input_parameter< const bool >::type accel(accelSEXP);
+    rcpp_result_gen = Rcpp::wrap(hMeanCov(Z, n, d, N, rhs, epsilon, iteMax, accel));
     return rcpp_result_gen;
 END_RCPP
 }
 // huberCov
-Rcpp::List huberCov(const arma::mat& X, const int n, const int p);
-RcppExport SEXP _FarmTest_huberCov(SEXP XSEXP, SEXP nSEXP, SEXP pSEXP) {
+Rcpp::List huberCov(SEXP X, const int n, const int p, const int d, const bool accel, Rcpp::Nullable<Rcpp::List> plan);
+RcppExport SEXP _FarmTest_huberCov(SEXP XSEXP, SEXP nSEXP, SEXP pSEXP, SEXP dSEXP, SEXP accelSEXP, SEXP planSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type X(XSEXP);
+    Rcpp::traits::input_parameter< const int >::type n(nSEXP);
+    Rcpp::traits::input_parameter< const int >::type p(pSEXP);
+    Rcpp::traits::input_parameter< const int >::type d(dSEXP);
+    Rcpp::traits::input_parameter< const bool >::type accel(accelSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::List> >::type plan(planSEXP);
+    rcpp_result_gen = Rcpp::wrap(huberCov(X, n, p, d, accel, plan));
+    return rcpp_result_gen;
+END_RCPP
+}
+// huberCovAppend
+Rcpp::List huberCovAppend(const arma::mat& X, const arma::mat& XNew, const arma::mat& sigma, const int n, const int p, const int pNew, const int d, const bool accel, Rcpp::Nullable<Rcpp::List> plan);
+RcppExport SEXP _FarmTest_huberCovAppend(SEXP XSEXP, SEXP XNewSEXP, SEXP sigmaSEXP, SEXP nSEXP, SEXP pSEXP, SEXP pNewSEXP, SEXP dSEXP, SEXP accelSEXP, SEXP planSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< const arma::mat& >::type X(XSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type XNew(XNewSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type sigma(sigmaSEXP);
     Rcpp::traits::input_parameter< const int >::type n(nSEXP);
     Rcpp::traits::input_parameter< const int >::type p(pSEXP);
-    rcpp_result_gen = Rcpp::wrap(huberCov(X, n, p));
+    Rcpp::traits::input_parameter< const int >::type pNew(pNewSEXP);
+    Rcpp::traits::input_parameter< const int >::type d(dSEXP);
+    Rcpp::traits::input_parameter< const bool >::type accel(accelSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::List> >::type plan(planSEXP);
+    rcpp_result_gen = Rcpp::wrap(huberCovAppend(X, XNew, sigma, n, p, pNew, d, accel, plan));
+    return rcpp_result_gen;
+END_RCPP
+}
+// huberCovPattern
+Rcpp::List huberCovPattern(SEXP X, const int n, const int p, const Rcpp::IntegerMatrix& pairs, const int d, const bool accel, Rcpp::Nullable<Rcpp::List> plan);
+RcppExport SEXP _FarmTest_huberCovPattern(SEXP XSEXP, SEXP nSEXP, SEXP pSEXP, SEXP pairsSEXP, SEXP dSEXP, SEXP accelSEXP, SEXP planSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type X(XSEXP);
+    Rcpp::traits::input_parameter< const int >::type n(nSEXP);
+    Rcpp::traits::input_parameter< const int >::type p(pSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::IntegerMatrix& >::type pairs(pairsSEXP);
+    Rcpp::traits::input_parameter< const int >::type d(dSEXP);
+    Rcpp::traits::input_parameter< const bool >::type accel(accelSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::List> >::type plan(planSEXP);
+    rcpp_result_gen = Rcpp::wrap(huberCovPattern(X, n, p, pairs, d, accel, plan));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -226,69 +295,73 @@ BEGIN_RCPP
 END_RCPP
 }
 // adaHuberReg
-arma::vec adaHuberReg(const arma::mat& X, arma::vec Y, const int n, const int p, const double tol, const int iteMax);
-RcppExport SEXP _FarmTest_adaHuberReg(SEXP XSEXP, SEXP YSEXP, SEXP nSEXP, SEXP pSEXP, SEXP tolSEXP, SEXP iteMaxSEXP) {
+Rcpp::NumericVector adaHuberReg(const arma::mat& X, const arma::vec& Y, const int n, const int p, const double tol, const int iteMax, const int solver);
+RcppExport SEXP _FarmTest_adaHuberReg(SEXP XSEXP, SEXP YSEXP, SEXP nSEXP, SEXP pSEXP, SEXP tolSEXP, SEXP iteMaxSEXP, SEXP solverSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< const arma::mat& >::type X(XSEXP);
-    Rcpp::traits::input_parameter< arma::vec >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type Y(YSEXP);
     Rcpp::traits::input_parameter< const int >::type n(nSEXP);
     Rcpp::traits::input_parameter< const int >::type p(pSEXP);
     Rcpp::traits::input_parameter< const double >::type tol(tolSEXP);
     Rcpp::traits::input_parameter< const int >::type iteMax(iteMaxSEXP);
-    rcpp_result_gen = Rcpp::wrap(adaHuberReg(X, Y, n, p, tol, iteMax));
+    Rcpp::traits::input_parameter< const int >::type solver(solverSEXP);
+    rcpp_result_gen = Rcpp::wrap(adaHuberReg(X, Y, n, p, tol, iteMax, solver));
     return rcpp_result_gen;
 END_RCPP
 }
 // huberReg
-arma::vec huberReg(const arma::mat& X, arma::vec Y, const int n, const int p, const double tol, const double constTau, const int iteMax);
-RcppExport SEXP _FarmTest_huberReg(SEXP XSEXP, SEXP YSEXP, SEXP nSEXP, SEXP pSEXP, SEXP tolSEXP, SEXP constTauSEXP, SEXP iteMaxSEXP) {
+Rcpp::NumericVector huberReg(const arma::mat& X, const arma::vec& Y, const int n, const int p, const double tol, const double constTau, const int iteMax, const int solver);
+RcppExport SEXP _FarmTest_huberReg(SEXP XSEXP, SEXP YSEXP, SEXP nSEXP, SEXP pSEXP, SEXP tolSEXP, SEXP constTauSEXP, SEXP iteMaxSEXP, SEXP solverSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< const arma::mat& >::type X(XSEXP);
-    Rcpp::traits::input_parameter< arma::vec >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type Y(YSEXP);
     Rcpp::traits::input_parameter< const int >::type n(nSEXP);
     Rcpp::traits::input_parameter< const int >::type p(pSEXP);
     Rcpp::traits::input_parameter< const double >::type tol(tolSEXP);
     Rcpp::traits::input_parameter< const double >::type constTau(constTauSEXP);
     Rcpp::traits::input_parameter< const int >::type iteMax(iteMaxSEXP);
-    rcpp_result_gen = Rcpp::wrap(huberReg(X, Y, n, p, tol, constTau, iteMax));
+    Rcpp::traits::input_parameter< const int >::type solver(solverSEXP);
+    rcpp_result_gen = Rcpp::wrap(huberReg(X, Y, n, p, tol, constTau, iteMax, solver));
     return rcpp_result_gen;
 END_RCPP
 }
 // huberRegCoef
-arma::vec huberRegCoef(const arma::mat& X, arma::vec Y, const int n, const int p, const double tol, const double constTau, const int iteMax);
-RcppExport SEXP _FarmTest_huberRegCoef(SEXP XSEXP, SEXP YSEXP, SEXP nSEXP, SEXP pSEXP, SEXP tolSEXP, SEXP constTauSEXP, SEXP iteMaxSEXP) {
+arma::vec huberRegCoef(const arma::mat& X, const arma::vec& Y, const int n, const int p, const double tol, const double constTau, const int iteMax, const int solver);
+RcppExport SEXP _FarmTest_huberRegCoef(SEXP XSEXP, SEXP YSEXP, SEXP nSEXP, SEXP pSEXP, SEXP tolSEXP, SEXP constTauSEXP, SEXP iteMaxSEXP, SEXP solverSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< const arma::mat& >::type X(XSEXP);
-    Rcpp::traits::input_parameter< arma::vec >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type Y(YSEXP);
     Rcpp::traits::input_parameter< const int >::type n(nSEXP);
     Rcpp::traits::input_parameter< const int >::type p(pSEXP);
     Rcpp::traits::input_parameter< const double >::type tol(tolSEXP);
     Rcpp::traits::input_parameter< const double >::type constTau(constTauSEXP);
     Rcpp::traits::input_parameter< const int >::type iteMax(iteMaxSEXP);
-    rcpp_result_gen = Rcpp::wrap(huberRegCoef(X, Y, n, p, tol, constTau, iteMax));
+    Rcpp::traits::input_parameter< const int >::type solver(solverSEXP);
+    rcpp_result_gen = Rcpp::wrap(huberRegCoef(X, Y, n, p, tol, constTau, iteMax, solver));
     return rcpp_result_gen;
 END_RCPP
 }
 // huberRegItcp
-double huberRegItcp(const arma::mat& X, arma::vec Y, const int n, const int p, const double tol, const double constTau, const int iteMax);
-RcppExport SEXP _FarmTest_huberRegItcp(SEXP XSEXP, SEXP YSEXP, SEXP nSEXP, SEXP pSEXP, SEXP tolSEXP, SEXP constTauSEXP, SEXP iteMaxSEXP) {
+double huberRegItcp(const arma::mat& X, const arma::vec& Y, const int n, const int p, const double tol, const double constTau, const int iteMax, const int solver);
+RcppExport SEXP _FarmTest_huberRegItcp(SEXP XSEXP, SEXP YSEXP, SEXP nSEXP, SEXP pSEXP, SEXP tolSEXP, SEXP constTauSEXP, SEXP iteMaxSEXP, SEXP solverSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< const arma::mat& >::type X(XSEXP);
-    Rcpp::traits::input_parameter< arma::vec >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type Y(YSEXP);
     Rcpp::traits::input_parameter< const int >::type n(nSEXP);
     Rcpp::traits::input_parameter< const int >::type p(pSEXP);
     Rcpp::traits::input_parameter< const double >::type tol(tolSEXP);
     Rcpp::traits::input_parameter< const double >::type constTau(constTauSEXP);
     Rcpp::traits::input_parameter< const int >::type iteMax(iteMaxSEXP);
-    rcpp_result_gen = Rcpp::wrap(huberRegItcp(X, Y, n, p, tol, constTau, iteMax));
+    Rcpp::traits::input_parameter< const int >::type solver(solverSEXP);
+    rcpp_result_gen = Rcpp::wrap(huberRegItcp(X, Y, n, p, tol, constTau, iteMax, solver));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -321,15 +394,42 @@ BEGIN_RCPP
 END_RCPP
 }
 // adjust
-arma::vec adjust(const arma::vec& Prob, const double alpha, const int p);
-RcppExport SEXP _FarmTest_adjust(SEXP ProbSEXP, SEXP alphaSEXP, SEXP pSEXP) {
+arma::vec adjust(const arma::vec& Prob, const double alpha, const int p, const int threads);
+RcppExport SEXP _FarmTest_adjust(SEXP ProbSEXP, SEXP alphaSEXP, SEXP pSEXP, SEXP threadsSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< const arma::vec& >::type Prob(ProbSEXP);
     Rcpp::traits::input_parameter< const double >::type alpha(alphaSEXP);
     Rcpp::traits::input_parameter< const int >::type p(pSEXP);
-    rcpp_result_gen = Rcpp::wrap(adjust(Prob, alpha, p));
+    Rcpp::traits::input_parameter< const int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(adjust(Prob, alpha, p, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// pHistAdd
+arma::vec pHistAdd(const arma::vec& P, arma::vec counts);
+RcppExport SEXP _FarmTest_pHistAdd(SEXP PSEXP, SEXP countsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::vec& >::type P(PSEXP);
+    Rcpp::traits::input_parameter< arma::vec >::type counts(countsSEXP);
+    rcpp_result_gen = Rcpp::wrap(pHistAdd(P, counts));
+    return rcpp_result_gen;
+END_RCPP
+}
+// adjustHist
+arma::vec adjustHist(const arma::vec& P, const arma::vec& counts, const double piHat, const double p);
+RcppExport SEXP _FarmTest_adjustHist(SEXP PSEXP, SEXP countsSEXP, SEXP piHatSEXP, SEXP pSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::vec& >::type P(PSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type counts(countsSEXP);
+    Rcpp::traits::input_parameter< const double >::type piHat(piHatSEXP);
+    Rcpp::traits::input_parameter< const double >::type p(pSEXP);
+    rcpp_result_gen = Rcpp::wrap(adjustHist(P, counts, piHat, p));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -346,38 +446,63 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// farmPlan
+Rcpp::List farmPlan(const double n, const double p, const int K, const bool covariance, const int B, const bool keepBoot, const double memory, int threads);
+RcppExport SEXP _FarmTest_farmPlan(SEXP nSEXP, SEXP pSEXP, SEXP KSEXP, SEXP covarianceSEXP, SEXP BSEXP, SEXP keepBootSEXP, SEXP memorySEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const double >::type n(nSEXP);
+    Rcpp::traits::input_parameter< const double >::type p(pSEXP);
+    Rcpp::traits::input_parameter< const int >::type K(KSEXP);
+    Rcpp::traits::input_parameter< const bool >::type covariance(covarianceSEXP);
+    Rcpp::traits::input_parameter< const int >::type B(BSEXP);
+    Rcpp::traits::input_parameter< const bool >::type keepBoot(keepBootSEXP);
+    Rcpp::traits::input_parameter< const double >::type memory(memorySEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(farmPlan(n, p, K, covariance, B, keepBoot, memory, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
 // rmTest
-Rcpp::List rmTest(const arma::mat& X, const arma::vec& h0, const double alpha, const std::string alternative);
-RcppExport SEXP _FarmTest_rmTest(SEXP XSEXP, SEXP h0SEXP, SEXP alphaSEXP, SEXP alternativeSEXP) {
+Rcpp::List rmTest(SEXP X, const arma::vec& h0, const double alpha, const std::string alternative, const bool profile, Rcpp::Nullable<Rcpp::Function> progress, const int bins);
+RcppExport SEXP _FarmTest_rmTest(SEXP XSEXP, SEXP h0SEXP, SEXP alphaSEXP, SEXP alternativeSEXP, SEXP profileSEXP, SEXP progressSEXP, SEXP binsSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< const arma::mat& >::type X(XSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type X(XSEXP);
     Rcpp::traits::input_parameter< const arma::vec& >::type h0(h0SEXP);
     Rcpp::traits::input_parameter< const double >::type alpha(alphaSEXP);
     Rcpp::traits::input_parameter< const std::string >::type alternative(alternativeSEXP);
-    rcpp_result_gen = Rcpp::wrap(rmTest(X, h0, alpha, alternative));
+    Rcpp::traits::input_parameter< const bool >::type profile(profileSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::Function> >::type progress(progressSEXP);
+    Rcpp::traits::input_parameter< const int >::type bins(binsSEXP);
+    rcpp_result_gen = Rcpp::wrap(rmTest(X, h0, alpha, alternative, profile, progress, bins));
     return rcpp_result_gen;
 END_RCPP
 }
 // rmTestBoot
-Rcpp::List rmTestBoot(const arma::mat& X, const arma::vec& h0, const double alpha, const std::string alternative, const int B);
-RcppExport SEXP _FarmTest_rmTestBoot(SEXP XSEXP, SEXP h0SEXP, SEXP alphaSEXP, SEXP alternativeSEXP, SEXP BSEXP) {
+Rcpp::List rmTestBoot(SEXP X, const arma::vec& h0, const double alpha, const std::string alternative, const int B, const bool profile, Rcpp::Nullable<Rcpp::Function> progress, const bool partial, const bool keepBoot);
+RcppExport SEXP _FarmTest_rmTestBoot(SEXP XSEXP, SEXP h0SEXP, SEXP alphaSEXP, SEXP alternativeSEXP, SEXP BSEXP, SEXP profileSEXP, SEXP progressSEXP, SEXP partialSEXP, SEXP keepBootSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< const arma::mat& >::type X(XSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type X(XSEXP);
     Rcpp::traits::input_parameter< const arma::vec& >::type h0(h0SEXP);
     Rcpp::traits::input_parameter< const double >::type alpha(alphaSEXP);
     Rcpp::traits::input_parameter< const std::string >::type alternative(alternativeSEXP);
     Rcpp::traits::input_parameter< const int >::type B(BSEXP);
-    rcpp_result_gen = Rcpp::wrap(rmTestBoot(X, h0, alpha, alternative, B));
+    Rcpp::traits::input_parameter< const bool >::type profile(profileSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::Function> >::type progress(progressSEXP);
+    Rcpp::traits::input_parameter< const bool >::type partial(partialSEXP);
+    Rcpp::traits::input_parameter< const bool >::type keepBoot(keepBootSEXP);
+    rcpp_result_gen = Rcpp::wrap(rmTestBoot(X, h0, alpha, alternative, B, profile, progress, partial, keepBoot));
     return rcpp_result_gen;
 END_RCPP
 }
 // rmTestTwo
-Rcpp::List rmTestTwo(const arma::mat& X, const arma::mat& Y, const arma::vec& h0, const double alpha, const std::string alternative);
-RcppExport SEXP _FarmTest_rmTestTwo(SEXP XSEXP, SEXP YSEXP, SEXP h0SEXP, SEXP alphaSEXP, SEXP alternativeSEXP) {
+Rcpp::List rmTestTwo(const arma::mat& X, const arma::mat& Y, const arma::vec& h0, const double alpha, const std::string alternative, const bool profile, Rcpp::Nullable<Rcpp::Function> progress);
+RcppExport SEXP _FarmTest_rmTestTwo(SEXP XSEXP, SEXP YSEXP, SEXP h0SEXP, SEXP alphaSEXP, SEXP alternativeSEXP, SEXP profileSEXP, SEXP progressSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -386,13 +511,15 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< const arma::vec& >::type h0(h0SEXP);
     Rcpp::traits::input_parameter< const double >::type alpha(alphaSEXP);
     Rcpp::traits::input_parameter< const std::string >::type alternative(alternativeSEXP);
-    rcpp_result_gen = Rcpp::wrap(rmTestTwo(X, Y, h0, alpha, alternative));
+    Rcpp::traits::input_parameter< const bool >::type profile(profileSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::Function> >::type progress(progressSEXP);
+    rcpp_result_gen = Rcpp::wrap(rmTestTwo(X, Y, h0, alpha, alternative, profile, progress));
     return rcpp_result_gen;
 END_RCPP
 }
 // rmTestTwoBoot
-Rcpp::List rmTestTwoBoot(const arma::mat& X, const arma::mat& Y, const arma::vec& h0, const double alpha, const std::string alternative, const int B);
-RcppExport SEXP _FarmTest_rmTestTwoBoot(SEXP XSEXP, SEXP YSEXP, SEXP h0SEXP, SEXP alphaSEXP, SEXP alternativeSEXP, SEXP BSEXP) {
+Rcpp::List rmTestTwoBoot(const arma::mat& X, const arma::mat& Y, const arma::vec& h0, const double alpha, const std::string alternative, const int B, const bool profile, Rcpp::Nullable<Rcpp::Function> progress, const bool partial, const bool keepBoot);
+RcppExport SEXP _FarmTest_rmTestTwoBoot(SEXP XSEXP, SEXP YSEXP, SEXP h0SEXP, SEXP alphaSEXP, SEXP alternativeSEXP, SEXP BSEXP, SEXP profileSEXP, SEXP progressSEXP, SEXP partialSEXP, SEXP keepBootSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -402,28 +529,77 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< const double >::type alpha(alphaSEXP);
     Rcpp::traits::input_parameter< const std::string >::type alternative(alternativeSEXP);
     Rcpp::traits::input_parameter< const int >::type B(BSEXP);
-    rcpp_result_gen = Rcpp::wrap(rmTestTwoBoot(X, Y, h0, alpha, alternative, B));
+    Rcpp::traits::input_parameter< const bool >::type profile(profileSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::Function> >::type progress(progressSEXP);
+    Rcpp::traits::input_parameter< const bool >::type partial(partialSEXP);
+    Rcpp::traits::input_parameter< const bool >::type keepBoot(keepBootSEXP);
+    rcpp_result_gen = Rcpp::wrap(rmTestTwoBoot(X, Y, h0, alpha, alternative, B, profile, progress, partial, keepBoot));
     return rcpp_result_gen;
 END_RCPP
 }
 // farmTest
-Rcpp::List farmTest(const arma::mat& X, const arma::vec& h0, int K, const double alpha, const std::string alternative);
-RcppExport SEXP _FarmTest_farmTest(SEXP XSEXP, SEXP h0SEXP, SEXP KSEXP, SEXP alphaSEXP, SEXP alternativeSEXP) {
+Rcpp::List farmTest(SEXP X, const arma::vec& h0, int K, const double alpha, const std::string alternative, const bool profile, Rcpp::Nullable<Rcpp::Function> progress, const int solver, Rcpp::Nullable<Rcpp::List> plan, Rcpp::Nullable<Rcpp::IntegerMatrix> pattern);
+RcppExport SEXP _FarmTest_farmTest(SEXP XSEXP, SEXP h0SEXP, SEXP KSEXP, SEXP alphaSEXP, SEXP alternativeSEXP, SEXP profileSEXP, SEXP progressSEXP, SEXP solverSEXP, SEXP planSEXP, SEXP patternSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< const arma::mat& >::type X(XSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type X(XSEXP);
     Rcpp::traits::input_parameter< const arma::vec& >::type h0(h0SEXP);
     Rcpp::traits::input_parameter< int >::type K(KSEXP);
     Rcpp::traits::input_parameter< const double >::type alpha(alphaSEXP);
     Rcpp::traits::input_parameter< const std::string >::type alternative(alternativeSEXP);
-    rcpp_result_gen = Rcpp::wrap(farmTest(X, h0, K, alpha, alternative));
+    Rcpp::traits::input_parameter< const bool >::type profile(profileSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::Function> >::type progress(progressSEXP);
+    Rcpp::traits::input_parameter< const int >::type solver(solverSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::List> >::type plan(planSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::IntegerMatrix> >::type pattern(patternSEXP);
+    rcpp_result_gen = Rcpp::wrap(farmTest(X, h0, K, alpha, alternative, profile, progress, solver, plan, pattern));
+    return rcpp_result_gen;
+END_RCPP
+}
+// farmTestRoll
+Rcpp::List farmTestRoll(SEXP X, const arma::vec& h0, const int width, const int step, const int K, const double alpha, const std::string alternative, const bool profile, Rcpp::Nullable<Rcpp::Function> progress, const int solver, Rcpp::Nullable<Rcpp::List> plan);
+RcppExport SEXP _FarmTest_farmTestRoll(SEXP XSEXP, SEXP h0SEXP, SEXP widthSEXP, SEXP stepSEXP, SEXP KSEXP, SEXP alphaSEXP, SEXP alternativeSEXP, SEXP profileSEXP, SEXP progressSEXP, SEXP solverSEXP, SEXP planSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type X(XSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type h0(h0SEXP);
+    Rcpp::traits::input_parameter< const int >::type width(widthSEXP);
+    Rcpp::traits::input_parameter< const int >::type step(stepSEXP);
+    Rcpp::traits::input_parameter< const int >::type K(KSEXP);
+    Rcpp::traits::input_parameter< const double >::type alpha(alphaSEXP);
+    Rcpp::traits::input_parameter< const std::string >::type alternative(alternativeSEXP);
+    Rcpp::traits::input_parameter< const bool >::type profile(profileSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::Function> >::type progress(progressSEXP);
+    Rcpp::traits::input_parameter< const int >::type solver(solverSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::List> >::type plan(planSEXP);
+    rcpp_result_gen = Rcpp::wrap(farmTestRoll(X, h0, width, step, K, alpha, alternative, profile, progress, solver, plan));
+    return rcpp_result_gen;
+END_RCPP
+}
+// farmTestSweep
+Rcpp::List farmTestSweep(SEXP X, const arma::vec& h0, const std::vector<int>& Ks, const double alpha, const std::string alternative, const bool profile, Rcpp::Nullable<Rcpp::Function> progress, const int solver, Rcpp::Nullable<Rcpp::List> plan);
+RcppExport SEXP _FarmTest_farmTestSweep(SEXP XSEXP, SEXP h0SEXP, SEXP KsSEXP, SEXP alphaSEXP, SEXP alternativeSEXP, SEXP profileSEXP, SEXP progressSEXP, SEXP solverSEXP, SEXP planSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type X(XSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type h0(h0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<int>& >::type Ks(KsSEXP);
+    Rcpp::traits::input_parameter< const double >::type alpha(alphaSEXP);
+    Rcpp::traits::input_parameter< const std::string >::type alternative(alternativeSEXP);
+    Rcpp::traits::input_parameter< const bool >::type profile(profileSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::Function> >::type progress(progressSEXP);
+    Rcpp::traits::input_parameter< const int >::type solver(solverSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::List> >::type plan(planSEXP);
+    rcpp_result_gen = Rcpp::wrap(farmTestSweep(X, h0, Ks, alpha, alternative, profile, progress, solver, plan));
     return rcpp_result_gen;
 END_RCPP
 }
 // farmTestTwo
-Rcpp::List farmTestTwo(const arma::mat& X, const arma::mat& Y, const arma::vec& h0, int KX, int KY, const double alpha, const std::string alternative);
-RcppExport SEXP _FarmTest_farmTestTwo(SEXP XSEXP, SEXP YSEXP, SEXP h0SEXP, SEXP KXSEXP, SEXP KYSEXP, SEXP alphaSEXP, SEXP alternativeSEXP) {
+Rcpp::List farmTestTwo(const arma::mat& X, const arma::mat& Y, const arma::vec& h0, int KX, int KY, const double alpha, const std::string alternative, const bool profile, Rcpp::Nullable<Rcpp::Function> progress, const int solver, Rcpp::Nullable<Rcpp::List> plan);
+RcppExport SEXP _FarmTest_farmTestTwo(SEXP XSEXP, SEXP YSEXP, SEXP h0SEXP, SEXP KXSEXP, SEXP KYSEXP, SEXP alphaSEXP, SEXP alternativeSEXP, SEXP profileSEXP, SEXP progressSEXP, SEXP solverSEXP, SEXP planSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -434,44 +610,76 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< int >::type KY(KYSEXP);
     Rcpp::traits::input_parameter< const double >::type alpha(alphaSEXP);
     Rcpp::traits::input_parameter< const std::string >::type alternative(alternativeSEXP);
-    rcpp_result_gen = Rcpp::wrap(farmTestTwo(X, Y, h0, KX, KY, alpha, alternative));
+    Rcpp::traits::input_parameter< const bool >::type profile(profileSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::Function> >::type progress(progressSEXP);
+    Rcpp::traits::input_parameter< const int >::type solver(solverSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::List> >::type plan(planSEXP);
+    rcpp_result_gen = Rcpp::wrap(farmTestTwo(X, Y, h0, KX, KY, alpha, alternative, profile, progress, solver, plan));
+    return rcpp_result_gen;
+END_RCPP
+}
+// farmTestGroups
+Rcpp::List farmTestGroups(const Rcpp::List& XList, const arma::vec& h0, const Rcpp::IntegerVector& KList, const arma::mat& contrasts, const double alpha, const std::string alternative, const bool profile, Rcpp::Nullable<Rcpp::Function> progress, const int solver, Rcpp::Nullable<Rcpp::List> plan);
+RcppExport SEXP _FarmTest_farmTestGroups(SEXP XListSEXP, SEXP h0SEXP, SEXP KListSEXP, SEXP contrastsSEXP, SEXP alphaSEXP, SEXP alternativeSEXP, SEXP profileSEXP, SEXP progressSEXP, SEXP solverSEXP, SEXP planSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const Rcpp::List& >::type XList(XListSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type h0(h0SEXP);
+    Rcpp::traits::input_parameter< const Rcpp::IntegerVector& >::type KList(KListSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type contrasts(contrastsSEXP);
+    Rcpp::traits::input_parameter< const double >::type alpha(alphaSEXP);
+    Rcpp::traits::input_parameter< const std::string >::type alternative(alternativeSEXP);
+    Rcpp::traits::input_parameter< const bool >::type profile(profileSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::Function> >::type progress(progressSEXP);
+    Rcpp::traits::input_parameter< const int >::type solver(solverSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::List> >::type plan(planSEXP);
+    rcpp_result_gen = Rcpp::wrap(farmTestGroups(XList, h0, KList, contrasts, alpha, alternative, profile, progress, solver, plan));
     return rcpp_result_gen;
 END_RCPP
 }
 // farmTestFac
-Rcpp::List farmTestFac(const arma::mat& X, const arma::mat& fac, const arma::vec& h0, const double alpha, const std::string alternative);
-RcppExport SEXP _FarmTest_farmTestFac(SEXP XSEXP, SEXP facSEXP, SEXP h0SEXP, SEXP alphaSEXP, SEXP alternativeSEXP) {
+Rcpp::List farmTestFac(SEXP X, const arma::mat& fac, const arma::vec& h0, const double alpha, const std::string alternative, const bool profile, Rcpp::Nullable<Rcpp::Function> progress, const int solver);
+RcppExport SEXP _FarmTest_farmTestFac(SEXP XSEXP, SEXP facSEXP, SEXP h0SEXP, SEXP alphaSEXP, SEXP alternativeSEXP, SEXP profileSEXP, SEXP progressSEXP, SEXP solverSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< const arma::mat& >::type X(XSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type X(XSEXP);
     Rcpp::traits::input_parameter< const arma::mat& >::type fac(facSEXP);
     Rcpp::traits::input_parameter< const arma::vec& >::type h0(h0SEXP);
     Rcpp::traits::input_parameter< const double >::type alpha(alphaSEXP);
     Rcpp::traits::input_parameter< const std::string >::type alternative(alternativeSEXP);
-    rcpp_result_gen = Rcpp::wrap(farmTestFac(X, fac, h0, alpha, alternative));
+    Rcpp::traits::input_parameter< const bool >::type profile(profileSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::Function> >::type progress(progressSEXP);
+    Rcpp::traits::input_parameter< const int >::type solver(solverSEXP);
+    rcpp_result_gen = Rcpp::wrap(farmTestFac(X, fac, h0, alpha, alternative, profile, progress, solver));
     return rcpp_result_gen;
 END_RCPP
 }
 // farmTestFacBoot
-Rcpp::List farmTestFacBoot(const arma::mat& X, const arma::mat& fac, const arma::vec& h0, const double alpha, const std::string alternative, const int B);
-RcppExport SEXP _FarmTest_farmTestFacBoot(SEXP XSEXP, SEXP facSEXP, SEXP h0SEXP, SEXP alphaSEXP, SEXP alternativeSEXP, SEXP BSEXP) {
+Rcpp::List farmTestFacBoot(SEXP X, const arma::mat& fac, const arma::vec& h0, const double alpha, const std::string alternative, const int B, const bool profile, Rcpp::Nullable<Rcpp::Function> progress, const bool partial, const int solver, const bool keepBoot);
+RcppExport SEXP _FarmTest_farmTestFacBoot(SEXP XSEXP, SEXP facSEXP, SEXP h0SEXP, SEXP alphaSEXP, SEXP alternativeSEXP, SEXP BSEXP, SEXP profileSEXP, SEXP progressSEXP, SEXP partialSEXP, SEXP solverSEXP, SEXP keepBootSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< const arma::mat& >::type X(XSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type X(XSEXP);
     Rcpp::traits::input_parameter< const arma::mat& >::type fac(facSEXP);
     Rcpp::traits::input_parameter< const arma::vec& >::type h0(h0SEXP);
     Rcpp::traits::input_parameter< const double >::type alpha(alphaSEXP);
     Rcpp::traits::input_parameter< const std::string >::type alternative(alternativeSEXP);
     Rcpp::traits::input_parameter< const int >::type B(BSEXP);
-    rcpp_result_gen = Rcpp::wrap(farmTestFacBoot(X, fac, h0, alpha, alternative, B));
+    Rcpp::traits::input_parameter< const bool >::type profile(profileSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::Function> >::type progress(progressSEXP);
+    Rcpp::traits::input_parameter< const bool >::type partial(partialSEXP);
+    Rcpp::traits::input_parameter< const int >::type solver(solverSEXP);
+    Rcpp::traits::input_parameter< const bool >::type keepBoot(keepBootSEXP);
+    rcpp_result_gen = Rcpp::wrap(farmTestFacBoot(X, fac, h0, alpha, alternative, B, profile, progress, partial, solver, keepBoot));
     return rcpp_result_gen;
 END_RCPP
 }
 // farmTestTwoFac
-Rcpp::List farmTestTwoFac(const arma::mat& X, const arma::mat& facX, const arma::mat& Y, const arma::mat& facY, const arma::vec& h0, const double alpha, const std::string alternative);
-RcppExport SEXP _FarmTest_farmTestTwoFac(SEXP XSEXP, SEXP facXSEXP, SEXP YSEXP, SEXP facYSEXP, SEXP h0SEXP, SEXP alphaSEXP, SEXP alternativeSEXP) {
+Rcpp::List farmTestTwoFac(const arma::mat& X, const arma::mat& facX, const arma::mat& Y, const arma::mat& facY, const arma::vec& h0, const double alpha, const std::string alternative, const bool profile, Rcpp::Nullable<Rcpp::Function> progress, const int solver);
+RcppExport SEXP _FarmTest_farmTestTwoFac(SEXP XSEXP, SEXP facXSEXP, SEXP YSEXP, SEXP facYSEXP, SEXP h0SEXP, SEXP alphaSEXP, SEXP alternativeSEXP, SEXP profileSEXP, SEXP progressSEXP, SEXP solverSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -482,13 +690,16 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< const arma::vec& >::type h0(h0SEXP);
     Rcpp::traits::input_parameter< const double >::type alpha(alphaSEXP);
     Rcpp::traits::input_parameter< const std::string >::type alternative(alternativeSEXP);
-    rcpp_result_gen = Rcpp::wrap(farmTestTwoFac(X, facX, Y, facY, h0, alpha, alternative));
+    Rcpp::traits::input_parameter< const bool >::type profile(profileSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::Function> >::type progress(progressSEXP);
+    Rcpp::traits::input_parameter< const int >::type solver(solverSEXP);
+    rcpp_result_gen = Rcpp::wrap(farmTestTwoFac(X, facX, Y, facY, h0, alpha, alternative, profile, progress, solver));
     return rcpp_result_gen;
 END_RCPP
 }
 // farmTestTwoFacBoot
-Rcpp::List farmTestTwoFacBoot(const arma::mat& X, const arma::mat& facX, const arma::mat& Y, const arma::mat& facY, const arma::vec& h0, const double alpha, const std::string alternative, const int B);
-RcppExport SEXP _FarmTest_farmTestTwoFacBoot(SEXP XSEXP, SEXP facXSEXP, SEXP YSEXP, SEXP facYSEXP, SEXP h0SEXP, SEXP alphaSEXP, SEXP alternativeSEXP, SEXP BSEXP) {
+Rcpp::List farmTestTwoFacBoot(const arma::mat& X, const arma::mat& facX, const arma::mat& Y, const arma::mat& facY, const arma::vec& h0, const double alpha, const std::string alternative, const int B, const bool profile, Rcpp::Nullable<Rcpp::Function> progress, const bool partial, const int solver, const bool keepBoot);
+RcppExport SEXP _FarmTest_farmTestTwoFacBoot(SEXP XSEXP, SEXP facXSEXP, SEXP YSEXP, SEXP facYSEXP, SEXP h0SEXP, SEXP alphaSEXP, SEXP alternativeSEXP, SEXP BSEXP, SEXP profileSEXP, SEXP progressSEXP, SEXP partialSEXP, SEXP solverSEXP, SEXP keepBootSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -500,7 +711,93 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< const double >::type alpha(alphaSEXP);
     Rcpp::traits::input_parameter< const std::string >::type alternative(alternativeSEXP);
     Rcpp::traits::input_parameter< const int >::type B(BSEXP);
-    rcpp_result_gen = Rcpp::wrap(farmTestTwoFacBoot(X, facX, Y, facY, h0, alpha, alternative, B));
+    Rcpp::traits::input_parameter< const bool >::type profile(profileSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::Function> >::type progress(progressSEXP);
+    Rcpp::traits::input_parameter< const bool >::type partial(partialSEXP);
+    Rcpp::traits::input_parameter< const int >::type solver(solverSEXP);
+    Rcpp::traits::input_parameter< const bool >::type keepBoot(keepBootSEXP);
+    rcpp_result_gen = Rcpp::wrap(farmTestTwoFacBoot(X, facX, Y, facY, h0, alpha, alternative, B, profile, progress, partial, solver, keepBoot));
+    return rcpp_result_gen;
+END_RCPP
+}
+// farmTestBatch
+Rcpp::List farmTestBatch(const Rcpp::List& XList, const Rcpp::List& facList, const Rcpp::List& h0List, const Rcpp::IntegerVector& KList, const double alpha, const std::string alternative, const bool pooled, const int nThreads, Rcpp::Nullable<Rcpp::Function> progress, const int solver);
+RcppExport SEXP _FarmTest_farmTestBatch(SEXP XListSEXP, SEXP facListSEXP, SEXP h0ListSEXP, SEXP KListSEXP, SEXP alphaSEXP, SEXP alternativeSEXP, SEXP pooledSEXP, SEXP nThreadsSEXP, SEXP progressSEXP, SEXP solverSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const Rcpp::List& >::type XList(XListSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::List& >::type facList(facListSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::List& >::type h0List(h0ListSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::IntegerVector& >::type KList(KListSEXP);
+    Rcpp::traits::input_parameter< const double >::type alpha(alphaSEXP);
+    Rcpp::traits::input_parameter< const std::string >::type alternative(alternativeSEXP);
+    Rcpp::traits::input_parameter< const bool >::type pooled(pooledSEXP);
+    Rcpp::traits::input_parameter< const int >::type nThreads(nThreadsSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::Function> >::type progress(progressSEXP);
+    Rcpp::traits::input_parameter< const int >::type solver(solverSEXP);
+    rcpp_result_gen = Rcpp::wrap(farmTestBatch(XList, facList, h0List, KList, alpha, alternative, pooled, nThreads, progress, solver));
+    return rcpp_result_gen;
+END_RCPP
+}
+// farmAsyncStart
+SEXP farmAsyncStart(SEXP X, const arma::mat& fac, const arma::vec& h0, const int K, const double alpha, const std::string alternative, const int solver);
+RcppExport SEXP _FarmTest_farmAsyncStart(SEXP XSEXP, SEXP facSEXP, SEXP h0SEXP, SEXP KSEXP, SEXP alphaSEXP, SEXP alternativeSEXP, SEXP solverSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type X(XSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type fac(facSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type h0(h0SEXP);
+    Rcpp::traits::input_parameter< const int >::type K(KSEXP);
+    Rcpp::traits::input_parameter< const double >::type alpha(alphaSEXP);
+    Rcpp::traits::input_parameter< const std::string >::type alternative(alternativeSEXP);
+    Rcpp::traits::input_parameter< const int >::type solver(solverSEXP);
+    rcpp_result_gen = Rcpp::wrap(farmAsyncStart(X, fac, h0, K, alpha, alternative, solver));
+    return rcpp_result_gen;
+END_RCPP
+}
+// farmAsyncStatus
+Rcpp::List farmAsyncStatus(SEXP handle);
+RcppExport SEXP _FarmTest_farmAsyncStatus(SEXP handleSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type handle(handleSEXP);
+    rcpp_result_gen = Rcpp::wrap(farmAsyncStatus(handle));
+    return rcpp_result_gen;
+END_RCPP
+}
+// farmAsyncWait
+bool farmAsyncWait(SEXP handle, const double timeout);
+RcppExport SEXP _FarmTest_farmAsyncWait(SEXP handleSEXP, SEXP timeoutSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type handle(handleSEXP);
+    Rcpp::traits::input_parameter< const double >::type timeout(timeoutSEXP);
+    rcpp_result_gen = Rcpp::wrap(farmAsyncWait(handle, timeout));
+    return rcpp_result_gen;
+END_RCPP
+}
+// farmAsyncCancel
+void farmAsyncCancel(SEXP handle);
+RcppExport SEXP _FarmTest_farmAsyncCancel(SEXP handleSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type handle(handleSEXP);
+    farmAsyncCancel(handle);
+    return R_NilValue;
+END_RCPP
+}
+// farmAsyncResult
+Rcpp::List farmAsyncResult(SEXP handle);
+RcppExport SEXP _FarmTest_farmAsyncResult(SEXP handleSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type handle(handleSEXP);
+    rcpp_result_gen = Rcpp::wrap(farmAsyncResult(handle));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -515,30 +812,46 @@ static const R_CallMethodDef CallEntries[] = {
     {"_FarmTest_rootg1", (DL_FUNC) &_FarmTest_rootg1, 7},
     {"_FarmTest_huberDer", (DL_FUNC) &_FarmTest_huberDer, 3},
     {"_FarmTest_huberMean", (DL_FUNC) &_FarmTest_huberMean, 4},
+    {"_FarmTest_huberMeanSecond", (DL_FUNC) &_FarmTest_huberMeanSecond, 4},
+    {"_FarmTest_huberMeanBinned", (DL_FUNC) &_FarmTest_huberMeanBinned, 5},
     {"_FarmTest_huberMeanVec", (DL_FUNC) &_FarmTest_huberMeanVec, 5},
-    {"_FarmTest_hMeanCov", (DL_FUNC) &_FarmTest_hMeanCov, 7},
-    {"_FarmTest_huberCov", (DL_FUNC) &_FarmTest_huberCov, 3},
+    {"_FarmTest_hMeanCov", (DL_FUNC) &_FarmTest_hMeanCov, 8},
+    {"_FarmTest_huberCov", (DL_FUNC) &_FarmTest_huberCov, 6},
+    {"_FarmTest_huberCovAppend", (DL_FUNC) &_FarmTest_huberCovAppend, 9},
+    {"_FarmTest_huberCovPattern", (DL_FUNC) &_FarmTest_huberCovPattern, 7},
     {"_FarmTest_mad", (DL_FUNC) &_FarmTest_mad, 1},
     {"_FarmTest_standardize", (DL_FUNC) &_FarmTest_standardize, 4},
     {"_FarmTest_updateHuber", (DL_FUNC) &_FarmTest_updateHuber, 7},
-    {"_FarmTest_adaHuberReg", (DL_FUNC) &_FarmTest_adaHuberReg, 6},
-    {"_FarmTest_huberReg", (DL_FUNC) &_FarmTest_huberReg, 7},
-    {"_FarmTest_huberRegCoef", (DL_FUNC) &_FarmTest_huberRegCoef, 7},
-    {"_FarmTest_huberRegItcp", (DL_FUNC) &_FarmTest_huberRegItcp, 7},
+    {"_FarmTest_adaHuberReg", (DL_FUNC) &_FarmTest_adaHuberReg, 7},
+    {"_FarmTest_huberReg", (DL_FUNC) &_FarmTest_huberReg, 8},
+    {"_FarmTest_huberRegCoef", (DL_FUNC) &_FarmTest_huberRegCoef, 8},
+    {"_FarmTest_huberRegItcp", (DL_FUNC) &_FarmTest_huberRegItcp, 8},
     {"_FarmTest_getP", (DL_FUNC) &_FarmTest_getP, 2},
     {"_FarmTest_getPboot", (DL_FUNC) &_FarmTest_getPboot, 6},
-    {"_FarmTest_adjust", (DL_FUNC) &_FarmTest_adjust, 3},
+    {"_FarmTest_adjust", (DL_FUNC) &_FarmTest_adjust, 4},
+    {"_FarmTest_pHistAdd", (DL_FUNC) &_FarmTest_pHistAdd, 2},
+    {"_FarmTest_adjustHist", (DL_FUNC) &_FarmTest_adjustHist, 4},
     {"_FarmTest_getRatio", (DL_FUNC) &_FarmTest_getRatio, 3},
-    {"_FarmTest_rmTest", (DL_FUNC) &_FarmTest_rmTest, 4},
-    {"_FarmTest_rmTestBoot", (DL_FUNC) &_FarmTest_rmTestBoot, 5},
-    {"_FarmTest_rmTestTwo", (DL_FUNC) &_FarmTest_rmTestTwo, 5},
-    {"_FarmTest_rmTestTwoBoot", (DL_FUNC) &_FarmTest_rmTestTwoBoot, 6},
-    {"_FarmTest_farmTest", (DL_FUNC) &_FarmTest_farmTest, 5},
-    {"_FarmTest_farmTestTwo", (DL_FUNC) &_FarmTest_farmTestTwo, 7},
-    {"_FarmTest_farmTestFac", (DL_FUNC) &_FarmTest_farmTestFac, 5},
-    {"_FarmTest_farmTestFacBoot", (DL_FUNC) &_FarmTest_farmTestFacBoot, 6},
-    {"_FarmTest_farmTestTwoFac", (DL_FUNC) &_FarmTest_farmTestTwoFac, 7},
-    {"_FarmTest_farmTestTwoFacBoot", (DL_FUNC) &_FarmTest_farmTestTwoFacBoot, 8},
+    {"_FarmTest_farmPlan", (DL_FUNC) &_FarmTest_farmPlan, 8},
+    {"_FarmTest_rmTest", (DL_FUNC) &_FarmTest_rmTest, 7},
+    {"_FarmTest_rmTestBoot", (DL_FUNC) &_FarmTest_rmTestBoot, 9},
+    {"_FarmTest_rmTestTwo", (DL_FUNC) &_FarmTest_rmTestTwo, 7},
+    {"_FarmTest_rmTestTwoBoot", (DL_FUNC) &_FarmTest_rmTestTwoBoot, 10},
+    {"_FarmTest_farmTest", (DL_FUNC) &_FarmTest_farmTest, 10},
+    {"_FarmTest_farmTestRoll", (DL_FUNC) &_FarmTest_farmTestRoll, 11},
+    {"_FarmTest_farmTestSweep", (DL_FUNC) &_FarmTest_farmTestSweep, 9},
+    {"_FarmTest_farmTestTwo", (DL_FUNC) &_FarmTest_farmTestTwo, 11},
+    {"_FarmTest_farmTestGroups", (DL_FUNC) &_FarmTest_farmTestGroups, 10},
+    {"_FarmTest_farmTestFac", (DL_FUNC) &_FarmTest_farmTestFac, 8},
+    {"_FarmTest_farmTestFacBoot", (DL_FUNC) &_FarmTest_farmTestFacBoot, 11},
+    {"_FarmTest_farmTestTwoFac", (DL_FUNC) &_FarmTest_farmTestTwoFac, 10},
+    {"_FarmTest_farmTestTwoFacBoot", (DL_FUNC) &_FarmTest_farmTestTwoFacBoot, 13},
+    {"_FarmTest_farmTestBatch", (DL_FUNC) &_FarmTest_farmTestBatch, 10},
+    {"_FarmTest_farmAsyncStart", (DL_FUNC) &_FarmTest_farmAsyncStart, 7},
+    {"_FarmTest_farmAsyncStatus", (DL_FUNC) &_FarmTest_farmAsyncStatus, 1},
+    {"_FarmTest_farmAsyncWait", (DL_FUNC) &_FarmTest_farmAsyncWait, 2},
+    {"_FarmTest_farmAsyncCancel", (DL_FUNC) &_FarmTest_farmAsyncCancel, 1},
+    {"_FarmTest_farmAsyncResult", (DL_FUNC) &_FarmTest_farmAsyncResult, 1},
     {NULL, NULL, 0}
 };
 